@@ -0,0 +1,131 @@
+// $Id: api.cpp,v 1.1 2026-10-19 12:00:00-07 - - $
+
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+using namespace std;
+
+#include "api.h"
+#include "collision.h"
+#include "debug.h"
+#include "graphics.h"
+#include "image.h"
+#include "svg.h"
+
+shape_ptr gdraw::make_text (const string& font, const string& textdata) {
+   void* glut_bitmap_font = bitmap_font (font);
+   if (glut_bitmap_font == nullptr) {
+      throw runtime_error (font + ": no such font");
+   }
+   return make_shared<text> (glut_bitmap_font, textdata);
+}
+
+shape_ptr gdraw::make_ellipse (GLfloat width, GLfloat height) {
+   return make_shared<ellipse> (width, height);
+}
+
+shape_ptr gdraw::make_circle (GLfloat diameter) {
+   return make_shared<circle> (diameter);
+}
+
+shape_ptr gdraw::make_polygon (vertex_list&& vertices) {
+   if (vertices.size() < 3) throw runtime_error ("too few vertices");
+   return make_shared<polygon> (move (vertices));
+}
+
+shape_ptr gdraw::make_rectangle (GLfloat width, GLfloat height) {
+   return make_shared<rectangle> (width, height);
+}
+
+shape_ptr gdraw::make_square (GLfloat width) {
+   return make_shared<square> (width);
+}
+
+shape_ptr gdraw::make_diamond (GLfloat width, GLfloat height) {
+   return make_shared<diamond> (width, height);
+}
+
+shape_ptr gdraw::make_equilateral (GLfloat width) {
+   return make_shared<equilateral> (width);
+}
+
+void gdraw::draw (const shape_ptr& pshape, const rgbcolor& color,
+                  const vertex& center) {
+   if (pshape == nullptr) throw runtime_error ("no shape to draw");
+   object obj;
+   obj.set (pshape, center, color);
+   window::push_back (obj);
+}
+
+void gdraw::draw_grid (const shape_ptr& pshape, const rgbcolor& color,
+                       const vertex& corner, size_t columns,
+                       size_t rows, const vertex& step) {
+   draw_grid (pshape, color, corner, columns, rows, step,
+              [] (const object& obj) { window::push_back (obj); });
+}
+
+void gdraw::draw_grid (const shape_ptr& pshape, const rgbcolor& color,
+                       const vertex& corner, size_t columns,
+                       size_t rows, const vertex& step,
+                       const place_fn& place) {
+   if (pshape == nullptr) throw runtime_error ("no shape to draw");
+   DEBUGF ('a', columns << "x" << rows);
+   object obj;
+   obj.set (pshape, corner, color);
+   for (size_t row = 0; row < rows; ++row) {
+      for (size_t column = 0; column < columns; ++column) {
+         obj.set_pos (corner.xpos + column * step.xpos,
+                      corner.ypos + row * step.ypos);
+         place (obj);
+      }
+   }
+}
+
+void gdraw::begin_group (const string& name) {
+   window::begin_group (name);
+}
+
+void gdraw::end_group() {
+   window::end_group();
+}
+
+void gdraw::set_border (const rgbcolor& color, GLfloat thickness) {
+   rgbcolor border_color = color;
+   window::set_border (border_color);
+   window::set_thick (thickness);
+}
+
+void gdraw::set_move (GLfloat pixels) {
+   window::set_move (pixels);
+}
+
+void gdraw::set_size (int width, int height) {
+   if (width <= 0 or height <= 0) throw runtime_error ("bad size");
+   window::setwidth (width);
+   window::setheight (height);
+}
+
+void gdraw::track_collisions() {
+   collisions::track();
+}
+
+const vector<pair<size_t,size_t>>& gdraw::overlapping() {
+   return collisions::update();
+}
+
+void gdraw::show() {
+   window::close_groups();
+   window::main();
+   exit (EXIT_SUCCESS);
+}
+
+int gdraw::export_image (const string& filename) {
+   window::close_groups();
+   return ::export_image (filename);
+}
+
+int gdraw::export_svg (const string& filename) {
+   window::close_groups();
+   return ::export_svg (filename);
+}
+
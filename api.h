@@ -0,0 +1,85 @@
+// $Id: api.h,v 1.1 2026-10-19 12:00:00-07 - - $
+
+//
+// gdraw -
+//    The scene as a C++ library, libgdraw.a, for programs that build
+//    scenes themselves instead of writing .gd text for gdraw to
+//    parse.  Shapes are made from numbers and vertex lists, objects
+//    are placed from shape pointers, and the scene is then shown in
+//    a window or rendered offscreen.  The .gd interpreter is a front
+//    end over these same calls.  For example:
+//
+//       shape_ptr dot = gdraw::make_circle (10);
+//       gdraw::draw_grid (dot, rgbcolor ("red"), {20, 20},
+//                         100, 100, {20, 20});
+//       return gdraw::export_svg ("dots.svg");
+//
+//    As in gdraw's own main, main must first call
+//    sys_info::execname (argv[0]), from util.h.  Link with
+//    libgdraw.a and the libraries in the Makefile's LINKLIBS.  Bad
+//    arguments throw runtime_error.
+//
+
+#ifndef __API_H__
+#define __API_H__
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+using namespace std;
+
+#include "rgbcolor.h"
+#include "shape.h"
+
+class object;
+
+class gdraw {
+   public:
+      gdraw() = delete;
+
+      // Shapes, like those of the define command.
+      static shape_ptr make_text (const string& font,
+                                  const string& textdata);
+      static shape_ptr make_ellipse (GLfloat width, GLfloat height);
+      static shape_ptr make_circle (GLfloat diameter);
+      static shape_ptr make_polygon (vertex_list&& vertices);
+      static shape_ptr make_rectangle (GLfloat width, GLfloat height);
+      static shape_ptr make_square (GLfloat width);
+      static shape_ptr make_diamond (GLfloat width, GLfloat height);
+      static shape_ptr make_equilateral (GLfloat width);
+
+      // Objects and settings, like the draw, drawgrid, group,
+      // endgroup, border and moveby commands.
+      static void draw (const shape_ptr&, const rgbcolor&,
+                        const vertex& center);
+      static void draw_grid (const shape_ptr&, const rgbcolor&,
+                             const vertex& corner, size_t columns,
+                             size_t rows, const vertex& step);
+      // The same, handing each object to place instead of adding
+      // it to the window.
+      using place_fn = function<void (const object&)>;
+      static void draw_grid (const shape_ptr&, const rgbcolor&,
+                             const vertex& corner, size_t columns,
+                             size_t rows, const vertex& step,
+                             const place_fn& place);
+      static void begin_group (const string& name);
+      static void end_group();
+      static void set_border (const rgbcolor&, GLfloat thickness);
+      static void set_move (GLfloat pixels);
+      static void set_size (int width, int height);
+
+      // Collisions, like the collisions command.  overlapping lists
+      // the pairs of objects, by index, that overlap now.
+      static void track_collisions();
+      static const vector<pair<size_t,size_t>>& overlapping();
+
+      // Output.  show runs the window until it is closed and does
+      // not return; the exports return EXIT_SUCCESS or EXIT_FAILURE.
+      [[noreturn]] static void show();
+      static int export_image (const string& filename); // PPM.
+      static int export_svg (const string& filename);
+};
+
+#endif
+
@@ -0,0 +1,226 @@
+// $Id: capture.cpp,v 1.1 2026-10-19 12:00:00-07 - - $
+
+// Must precede the first GL header to declare the GL 3.0 functions.
+#define GL_GLEXT_PROTOTYPES
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+using namespace std;
+
+#include <GL/freeglut.h>
+
+#include "capture.h"
+#include "debug.h"
+#include "util.h"
+
+uint64_t frame_capture::every {0};
+bool frame_capture::wanted {false};
+bool frame_capture::buffers {false};
+bool frame_capture::fences {false};
+uint64_t frame_capture::frame {0};
+size_t frame_capture::next {0};
+bool frame_capture::polling {false};
+array<frame_capture::slot,frame_capture::ring_size> frame_capture::ring;
+size_t frame_capture::dropped {0};
+// Never destroyed: the detached writer may still be waiting on them
+// while static destructors run at exit.
+mutex& frame_capture::queue_lock = *new mutex;
+condition_variable& frame_capture::wakeup = *new condition_variable;
+condition_variable& frame_capture::drained = *new condition_variable;
+deque<frame_capture::image> frame_capture::queued;
+vector<vector<GLubyte>> frame_capture::spare;
+bool frame_capture::writing {false};
+
+void frame_capture::init() {
+   int major = 0;
+   int minor = 0;
+   const char* version = reinterpret_cast<const char*>
+                         (glGetString (GL_VERSION));
+   if (version != nullptr) sscanf (version, "%d.%d", &major, &minor);
+   buffers = major > 2 or (major == 2 and minor >= 1);
+   fences = major > 3 or (major == 3 and minor >= 2);
+   DEBUGF ('C', "GL " << major << "." << minor << ", buffers "
+           << buffers << ", fences " << fences);
+   if (buffers) {
+      for (slot& each: ring) glGenBuffers (1, &each.buffer);
+   }
+   thread (writer).detach();
+   atexit (finish);
+}
+
+// A buffer for bytes of pixels, reusing one already written if
+// there is one, unless the writer is too far behind.
+bool frame_capture::take (image& result, size_t bytes) {
+   lock_guard<mutex> guard (queue_lock);
+   if (queued.size() >= queue_limit) {
+      ++dropped;
+      return false;
+   }
+   if (not spare.empty()) {
+      result.pixels = move (spare.back());
+      spare.pop_back();
+   }
+   result.pixels.resize (bytes);
+   return true;
+}
+
+void frame_capture::hand_over (image&& result) {
+   lock_guard<mutex> guard (queue_lock);
+   queued.push_back (move (result));
+   wakeup.notify_one();
+}
+
+// A buffer taken for a capture that failed, which is dropped.
+void frame_capture::give_back (image&& result) {
+   lock_guard<mutex> guard (queue_lock);
+   spare.push_back (move (result.pixels));
+   ++dropped;
+}
+
+// Whether mapping the slot's buffer would not wait for the read.
+// Without fences, a read issued a frame before is taken as done.
+bool frame_capture::ready (const slot& issued, bool wait) {
+   if (wait) return true;
+   if (not fences) return frame > issued.frame + 1;
+   GLenum status = glClientWaitSync (issued.fence, 0, 0);
+   return status == GL_ALREADY_SIGNALED
+       or status == GL_CONDITION_SATISFIED;
+}
+
+// Map the busy slots, oldest first, and pass their pixels to the
+// writer.  Stops at the first one not yet ready unless wait.
+void frame_capture::collect (bool wait) {
+   for (size_t count = 0; count < ring_size; ++count) {
+      slot& issued = ring[(next + count) % ring_size];
+      if (not issued.busy) continue;
+      if (not ready (issued, wait)) break;
+      if (issued.fence != nullptr) {
+         glDeleteSync (issued.fence);
+         issued.fence = nullptr;
+      }
+      issued.busy = false;
+      size_t bytes = size_t (issued.width) * issued.height * 3;
+      image result {issued.frame, issued.width, issued.height, {}};
+      if (not take (result, bytes)) continue;
+      glBindBuffer (GL_PIXEL_PACK_BUFFER, issued.buffer);
+      const void* mapped = glMapBuffer (GL_PIXEL_PACK_BUFFER,
+                                        GL_READ_ONLY);
+      if (mapped != nullptr) {
+         memcpy (result.pixels.data(), mapped, bytes);
+         glUnmapBuffer (GL_PIXEL_PACK_BUFFER);
+      }
+      glBindBuffer (GL_PIXEL_PACK_BUFFER, 0);
+      if (mapped != nullptr) hand_over (move (result));
+                        else give_back (move (result));
+   }
+}
+
+// Collects reads left over when no more frames are drawn.
+void frame_capture::poll (int) {
+   collect (not fences);
+   polling = false;
+   for (const slot& each: ring) polling = polling or each.busy;
+   if (polling) glutTimerFunc (poll_msecs, poll, 0);
+}
+
+void frame_capture::frame_drawn (int width, int height) {
+   auto start = chrono::steady_clock::now();
+   ++frame;
+   collect (false);
+   bool periodic = every > 0 and frame % every == 0;
+   if (not wanted and not periodic) return;
+   wanted = false;
+   if (width <= 0 or height <= 0) return;
+   size_t bytes = size_t (width) * height * 3;
+   glPixelStorei (GL_PACK_ALIGNMENT, 1);
+   if (not buffers) {
+      image result {frame, width, height, {}};
+      if (not take (result, bytes)) return;
+      glReadPixels (0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE,
+                    result.pixels.data());
+      hand_over (move (result));
+      return;
+   }
+   slot& issued = ring[next];
+   if (issued.busy) {
+      ++dropped;
+      return;
+   }
+   glBindBuffer (GL_PIXEL_PACK_BUFFER, issued.buffer);
+   if (bytes > issued.bytes) {
+      glBufferData (GL_PIXEL_PACK_BUFFER, bytes, nullptr,
+                    GL_STREAM_READ);
+      issued.bytes = bytes;
+   }
+   glReadPixels (0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE,
+                 nullptr);
+   glBindBuffer (GL_PIXEL_PACK_BUFFER, 0);
+   if (fences) {
+      issued.fence = glFenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+   }
+   issued.busy = true;
+   issued.frame = frame;
+   issued.width = width;
+   issued.height = height;
+   next = (next + 1) % ring_size;
+   if (not polling) {
+      polling = true;
+      glutTimerFunc (poll_msecs, poll, 0);
+   }
+   chrono::duration<double,milli> elapsed
+         = chrono::steady_clock::now() - start;
+   DEBUGF ('C', "frame " << frame << " read issued in "
+           << elapsed.count() << " ms");
+}
+
+// Runs in the writer thread.  GL rows run from the bottom, PPM rows
+// from the top.
+void frame_capture::writer() {
+   for (;;) {
+      image result;
+      {
+         unique_lock<mutex> lock (queue_lock);
+         wakeup.wait (lock, [] () { return not queued.empty(); });
+         result = move (queued.front());
+         queued.pop_front();
+         writing = true;
+      }
+      char filename[32];
+      snprintf (filename, sizeof filename, "gdraw-%06llu.ppm",
+                static_cast<unsigned long long> (result.frame));
+      ofstream file (filename, ios::binary);
+      file << "P6\n" << result.width << " " << result.height
+           << "\n255\n";
+      size_t row_bytes = size_t (result.width) * 3;
+      for (int row = result.height - 1; row >= 0; --row) {
+         file.write (reinterpret_cast<const char*>
+                     (&result.pixels[row * row_bytes]), row_bytes);
+      }
+      file.close();
+      if (file.fail()) syscall_error (filename);
+                  else DEBUGF ('C', filename << " written");
+      lock_guard<mutex> guard (queue_lock);
+      spare.push_back (move (result.pixels));
+      writing = false;
+      drained.notify_all();
+   }
+}
+
+// Registered with atexit, while the GL context is still current.
+void frame_capture::finish() {
+   collect (true);
+   unique_lock<mutex> lock (queue_lock);
+   drained.wait (lock, [] () {
+      return queued.empty() and not writing;
+   });
+   if (dropped > 0) {
+      cerr << sys_info::execname() << ": " << dropped
+           << " captures dropped" << endl;
+   }
+}
+
@@ -0,0 +1,84 @@
+// $Id: capture.h,v 1.1 2026-10-19 12:00:00-07 - - $
+
+//
+// frame_capture -
+//    Screenshots of the window, taken with the s key or every n
+//    frames with --capture-every=n, and written as PPM files named
+//    gdraw-<frame>.ppm.  The back buffer is read into one of a ring
+//    of pixel buffer objects just before the swap, which only
+//    queues the copy.  The buffer is mapped a frame or two later,
+//    once its fence has passed, or from a timer if no more frames
+//    are drawn, and its pixels are handed to a background thread
+//    that writes the file.  A capture that finds the ring or the
+//    writer's queue full is dropped rather than waited for, and
+//    counted.  Whatever is still pending is written at exit.
+//    Without pixel buffer objects (GL 2.1), the read is done at
+//    once, but the file is still written in the background.
+//
+
+#ifndef __CAPTURE_H__
+#define __CAPTURE_H__
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+using namespace std;
+
+#include <GL/freeglut.h>
+
+class frame_capture {
+   private:
+      struct slot {             // One pixel buffer object.
+         GLuint buffer {0};
+         GLsync fence {nullptr};
+         size_t bytes {0};      // Allocated to buffer.
+         bool busy {false};     // Read issued, not yet mapped.
+         uint64_t frame {0};
+         int width {0};
+         int height {0};
+      };
+      struct image {            // Waiting for the writer.
+         uint64_t frame;
+         int width;
+         int height;
+         vector<GLubyte> pixels;
+      };
+      static constexpr size_t ring_size = 3;
+      static constexpr size_t queue_limit = 8;
+      static constexpr unsigned poll_msecs = 20;
+      static uint64_t every;    // Frames between captures, or 0.
+      static bool wanted;       // By the s key.
+      static bool buffers;      // Pixel buffer objects available.
+      static bool fences;       // Fence syncs available.
+      static uint64_t frame;
+      static size_t next;       // Slot of the next capture.
+      static bool polling;
+      static array<slot,ring_size> ring;
+      static size_t dropped;
+      static mutex& queue_lock; // Guards queued, spare, writing.
+      static condition_variable& wakeup;
+      static condition_variable& drained;
+      static deque<image> queued;
+      static vector<vector<GLubyte>> spare; // Written, for reuse.
+      static bool writing;
+      static bool take (image& result, size_t bytes);
+      static void hand_over (image&& result);
+      static void give_back (image&& result);
+      static bool ready (const slot&, bool wait);
+      static void collect (bool wait);
+      static void poll (int);
+      static void writer();
+      static void finish();
+   public:
+      frame_capture() = delete;
+      static void set_every (uint64_t frames) { every = frames; }
+      static void request() { wanted = true; }
+      static void init(); // After the GL context exists.
+      static void frame_drawn (int width, int height); // Before swap.
+};
+
+#endif
+
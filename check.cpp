@@ -0,0 +1,99 @@
+// $Id: check.cpp,v 1.1 2026-10-19 12:00:00-07 - - $
+
+#include <cerrno>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+using namespace std;
+
+#include "check.h"
+#include "debug.h"
+#include "graphics.h"
+#include "interp.h"
+#include "util.h"
+
+// Write all of a buffer with as few write(2) calls as possible, so
+// diagnostics for one file are not interleaved with another's.
+static void write_all (int fd, const string& buffer) {
+   const char* data = buffer.data();
+   size_t left = buffer.size();
+   while (left > 0) {
+      ssize_t written = write (fd, data, left);
+      if (written < 0) {
+         if (errno == EINTR) continue;
+         return;
+      }
+      data += written;
+      left -= written;
+   }
+}
+
+// Interpret one file from a clean scene, collecting its diagnostics.
+static bool check_file (const string& filename) {
+   ostringstream diagnostics;
+   streambuf* saved = cerr.rdbuf (diagnostics.rdbuf());
+   sys_info::exit_status (EXIT_SUCCESS);
+   ifstream infile (filename);
+   if (infile.fail()) {
+      syscall_error (filename);
+   }else {
+      parsefile (filename, infile, false);
+   }
+   window::clear();
+   interpreter::clear();
+   cerr.rdbuf (saved);
+   write_all (STDERR_FILENO, diagnostics.str());
+   return sys_info::exit_status() == EXIT_SUCCESS;
+}
+
+// Check every jobs'th file starting at first.
+static bool check_stride (const vector<string>& filenames,
+                          size_t first, size_t jobs) {
+   bool valid = true;
+   for (size_t index = first; index < filenames.size(); index += jobs) {
+      if (not check_file (filenames[index])) valid = false;
+   }
+   return valid;
+}
+
+int check_files (const vector<string>& filenames, int jobs) {
+   interpreter::set_strict (true);
+   if (jobs <= 0) jobs = sysconf (_SC_NPROCESSORS_ONLN);
+   size_t workers = min<size_t> (max (jobs, 1), filenames.size());
+   DEBUGF ('k', filenames.size() << " files, " << workers << " jobs");
+   bool valid = true;
+   if (workers <= 1) {
+      valid = check_stride (filenames, 0, 1);
+   }else {
+      cout.flush();
+      cerr.flush();
+      vector<pid_t> children;
+      for (size_t worker = 0; worker < workers; ++worker) {
+         pid_t pid = fork();
+         if (pid == 0) {
+            bool ok = check_stride (filenames, worker, workers);
+            cout.flush();
+            debugflags::flush();
+            _exit (ok ? EXIT_SUCCESS : EXIT_FAILURE);
+         }
+         if (pid < 0) {
+            syscall_error ("fork");
+            valid = check_stride (filenames, worker, workers)
+                    and valid;
+         }else {
+            children.push_back (pid);
+         }
+      }
+      for (pid_t pid: children) {
+         int status = -1;
+         while (waitpid (pid, &status, 0) < 0 and errno == EINTR) {}
+         if (not WIFEXITED (status)
+             or WEXITSTATUS (status) != EXIT_SUCCESS) valid = false;
+      }
+   }
+   sys_info::exit_status (valid ? EXIT_SUCCESS : EXIT_FAILURE);
+   return sys_info::exit_status();
+}
+
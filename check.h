@@ -0,0 +1,28 @@
+// $Id: check.h,v 1.1 2026-10-19 12:00:00-07 - - $
+
+//
+// check -
+//    Validate .gd files without opening a window.  Files are divided
+//    among worker processes, each of which interprets its files in
+//    turn and reports diagnostics in the usual file:line: format.
+//    Drawing an undefined shape is an error rather than a warning.
+//
+
+#ifndef __CHECK_H__
+#define __CHECK_H__
+
+#include <string>
+#include <vector>
+using namespace std;
+
+//
+// check_files -
+//    Check every file using at most jobs worker processes, or one
+//    per processor if jobs is zero.  Returns EXIT_SUCCESS if all of
+//    the files are valid.
+//
+
+int check_files (const vector<string>& filenames, int jobs);
+
+#endif
+
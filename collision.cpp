@@ -0,0 +1,316 @@
+// $Id: collision.cpp,v 1.1 2026-10-19 12:00:00-07 - - $
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <numeric>
+using namespace std;
+
+#include "collision.h"
+#include "debug.h"
+#include "graphics.h"
+
+bool collisions::tracking {false};
+vector<bbox> collisions::boxes;
+vector<char> collisions::stale;
+vector<size_t> collisions::dirty;
+GLfloat collisions::widest {0};
+vector<size_t> collisions::order;
+collisions::pair_list collisions::pairs;
+
+//
+// The narrow phase, in world coordinates.
+//
+
+struct body {
+   vertex center;
+   bool round;           // An ellipse with these radii, or else
+   vertex radii;         // a polygon with these points.
+   vertex_list points;
+};
+
+static body body_of (size_t index) {
+   const object& obj = window::at (index);
+   const shape& form = obj.get_shape();
+   vertex offset = window::world_offset (index);
+   vertex center = obj.get_pos();
+   center.xpos += offset.xpos;
+   center.ypos += offset.ypos;
+   bbox bounds = form.bounds();
+   if (form.kind() == primitive::ELLIPSE and bounds.high.xpos > 0
+       and bounds.high.ypos > 0) {
+      return {center, true, bounds.high, {}};
+   }
+   vertex_list points = form.contour();
+   if (points.empty()) {
+      points = {bounds.low, {bounds.high.xpos, bounds.low.ypos},
+                bounds.high, {bounds.low.xpos, bounds.high.ypos}};
+   }
+   for (vertex& point: points) {
+      point.xpos += center.xpos;
+      point.ypos += center.ypos;
+   }
+   return {center, false, {0, 0}, move (points)};
+}
+
+static GLfloat cross (const vertex& origin, const vertex& first,
+                      const vertex& second) {
+   return (first.xpos - origin.xpos) * (second.ypos - origin.ypos)
+        - (first.ypos - origin.ypos) * (second.xpos - origin.xpos);
+}
+
+static bool segments_cross (const vertex& a0, const vertex& a1,
+                            const vertex& b0, const vertex& b1) {
+   GLfloat d0 = cross (b0, b1, a0);
+   GLfloat d1 = cross (b0, b1, a1);
+   GLfloat d2 = cross (a0, a1, b0);
+   GLfloat d3 = cross (a0, a1, b1);
+   if (((d0 > 0 and d1 < 0) or (d0 < 0 and d1 > 0))
+       and ((d2 > 0 and d3 < 0) or (d2 < 0 and d3 > 0))) return true;
+   auto on = [] (const vertex& p, const vertex& q, const vertex& r) {
+      return min (p.xpos, q.xpos) <= r.xpos
+         and r.xpos <= max (p.xpos, q.xpos)
+         and min (p.ypos, q.ypos) <= r.ypos
+         and r.ypos <= max (p.ypos, q.ypos);
+   };
+   return (d0 == 0 and on (b0, b1, a0))
+       or (d1 == 0 and on (b0, b1, a1))
+       or (d2 == 0 and on (a0, a1, b0))
+       or (d3 == 0 and on (a0, a1, b1));
+}
+
+// Even-odd rule, so outlines that cross themselves work as drawn.
+static bool inside (const vertex_list& points, const vertex& point) {
+   bool result = false;
+   for (size_t index = 0, prev = points.size() - 1;
+        index < points.size(); prev = index++) {
+      const vertex& here = points[index];
+      const vertex& there = points[prev];
+      if ((here.ypos > point.ypos) != (there.ypos > point.ypos)
+          and point.xpos < (there.xpos - here.xpos)
+                           * (point.ypos - here.ypos)
+                           / (there.ypos - here.ypos) + here.xpos) {
+         result = not result;
+      }
+   }
+   return result;
+}
+
+static bool polygons_overlap (const vertex_list& first,
+                              const vertex_list& second) {
+   for (size_t index = 0, prev = first.size() - 1;
+        index < first.size(); prev = index++) {
+      for (size_t other = 0, before = second.size() - 1;
+           other < second.size(); before = other++) {
+         if (segments_cross (first[prev], first[index],
+                             second[before], second[other])) {
+            return true;
+         }
+      }
+   }
+   return inside (second, first[0]) or inside (first, second[0]);
+}
+
+// Scaled so the ellipse is the unit circle, the points overlap it if
+// it is inside them or one of their edges comes within 1 of it.
+static bool ellipse_overlaps (const body& round,
+                              const vertex_list& points) {
+   vertex_list scaled;
+   scaled.reserve (points.size());
+   for (const vertex& point: points) {
+      scaled.push_back ({(point.xpos - round.center.xpos)
+                         / round.radii.xpos,
+                         (point.ypos - round.center.ypos)
+                         / round.radii.ypos});
+   }
+   if (inside (scaled, {0, 0})) return true;
+   for (size_t index = 0, prev = scaled.size() - 1;
+        index < scaled.size(); prev = index++) {
+      const vertex& start = scaled[prev];
+      vertex edge {scaled[index].xpos - start.xpos,
+                   scaled[index].ypos - start.ypos};
+      GLfloat length = edge.xpos * edge.xpos + edge.ypos * edge.ypos;
+      GLfloat along = length == 0 ? 0
+                    : -(start.xpos * edge.xpos + start.ypos * edge.ypos)
+                      / length;
+      along = max (GLfloat (0), min (GLfloat (1), along));
+      GLfloat xpos = start.xpos + along * edge.xpos;
+      GLfloat ypos = start.ypos + along * edge.ypos;
+      if (xpos * xpos + ypos * ypos <= 1) return true;
+   }
+   return false;
+}
+
+static vertex_list ellipse_points (const body& round) {
+   const int segments = 32;
+   vertex_list points;
+   points.reserve (segments);
+   for (int segment = 0; segment < segments; ++segment) {
+      GLfloat theta = segment * 2 * M_PI / segments;
+      points.push_back ({round.center.xpos
+                         + round.radii.xpos * cosf (theta),
+                         round.center.ypos
+                         + round.radii.ypos * sinf (theta)});
+   }
+   return points;
+}
+
+bool collisions::overlap (size_t first, size_t second) {
+   body one = body_of (first);
+   body two = body_of (second);
+   if (one.round and two.round) {
+      if (one.radii.xpos == one.radii.ypos
+          and two.radii.xpos == two.radii.ypos) {
+         GLfloat xdist = one.center.xpos - two.center.xpos;
+         GLfloat ydist = one.center.ypos - two.center.ypos;
+         GLfloat reach = one.radii.xpos + two.radii.xpos;
+         return xdist * xdist + ydist * ydist <= reach * reach;
+      }
+      return ellipse_overlaps (two, ellipse_points (one));
+   }
+   if (one.round) return ellipse_overlaps (one, two.points);
+   if (two.round) return ellipse_overlaps (two, one.points);
+   return polygons_overlap (one.points, two.points);
+}
+
+//
+// The broad phase.
+//
+
+void collisions::moved (size_t first, size_t last) {
+   if (not tracking) return;
+   last = min (last, stale.size());
+   for (size_t index = first; index < last; ++index) {
+      if (stale[index]) continue;
+      stale[index] = 1;
+      dirty.push_back (index);
+   }
+}
+
+void collisions::forget() {
+   boxes.clear();
+   stale.clear();
+   dirty.clear();
+   widest = 0;
+   order.clear();
+   pairs.clear();
+}
+
+// Every pair whose bounds overlap, in one sweep along x.
+collisions::pair_list collisions::sweep() {
+   pair_list found;
+   vector<size_t> active; // Whose bounds reach the sweep line.
+   for (size_t index: order) {
+      const bbox& box = boxes[index];
+      if (box.empty()) continue;
+      for (size_t slot = 0; slot < active.size();) {
+         if (boxes[active[slot]].high.xpos < box.low.xpos) {
+            active[slot] = active.back();
+            active.pop_back();
+            continue;
+         }
+         size_t other = active[slot++];
+         const bbox& near = boxes[other];
+         if (near.high.ypos < box.low.ypos
+             or box.high.ypos < near.low.ypos) continue;
+         pair<size_t,size_t> candidate = minmax (index, other);
+         bool overlapping = stale[index] or stale[other]
+                          ? overlap (index, other)
+                          : binary_search (pairs.begin(), pairs.end(),
+                                           candidate);
+         if (overlapping) found.push_back (candidate);
+      }
+      active.push_back (index);
+   }
+   return found;
+}
+
+// The pairs of objects that have not moved, and those found by
+// looking along x for whatever might overlap each one that has.
+collisions::pair_list collisions::requery() {
+   pair_list found;
+   for (const auto& each: pairs) {
+      if (not stale[each.first] and not stale[each.second]) {
+         found.push_back (each);
+      }
+   }
+   for (size_t index: dirty) {
+      const bbox& box = boxes[index];
+      if (box.empty()) continue;
+      auto other = lower_bound (order.begin(), order.end(),
+                                box.low.xpos - widest,
+                                [] (size_t each, GLfloat xpos) {
+                                   return boxes[each].low.xpos < xpos;
+                                });
+      for (; other != order.end()
+             and boxes[*other].low.xpos <= box.high.xpos; ++other) {
+         if (*other == index or (stale[*other] and *other < index)) {
+            continue;
+         }
+         if (not boxes[*other].overlaps (box)) continue;
+         if (overlap (index, *other)) {
+            found.push_back (minmax (index, *other));
+         }
+      }
+   }
+   return found;
+}
+
+// A full sweep if the objects are new or many have moved, or else
+// only around those that have, which are taken out of the order by
+// x and merged back in.
+const collisions::pair_list& collisions::update() {
+   size_t count = window::size();
+   if (count != boxes.size()) {
+      boxes.resize (count);
+      stale.assign (count, 1);
+      dirty.resize (count);
+      iota (dirty.begin(), dirty.end(), 0);
+      order = dirty;
+      pairs.clear();
+      widest = 0;
+   }
+   if (dirty.empty()) return pairs;
+   for (size_t index: dirty) {
+      boxes[index] = window::at (index).bounds()
+                   + window::world_offset (index);
+      if (boxes[index].empty()) continue;
+      widest = max (widest, boxes[index].high.xpos
+                            - boxes[index].low.xpos);
+   }
+   bool full = dirty.size() > count / 16;
+   auto by_left = [] (size_t one, size_t two) {
+      return boxes[one].low.xpos < boxes[two].low.xpos;
+   };
+   if (full) {
+      sort (order.begin(), order.end(), by_left);
+   }else {
+      auto moved = [] (size_t index) { return stale[index] != 0; };
+      order.erase (remove_if (order.begin(), order.end(), moved),
+                   order.end());
+      vector<size_t> moving = dirty;
+      sort (moving.begin(), moving.end(), by_left);
+      vector<size_t> merged;
+      merged.reserve (count);
+      merge (order.begin(), order.end(), moving.begin(), moving.end(),
+             back_inserter (merged), by_left);
+      order = move (merged);
+   }
+   pair_list found = full ? sweep() : requery();
+   sort (found.begin(), found.end());
+
+   pair_list begun;
+   set_difference (found.begin(), found.end(), pairs.begin(),
+                   pairs.end(), back_inserter (begun));
+   for (const auto& each: begun) {
+      cout << "collision " << each.first << " " << each.second << '\n';
+   }
+   if (not begun.empty()) cout.flush();
+   DEBUGF ('o', found.size() << " pairs, " << begun.size() << " new, "
+           << dirty.size() << (full ? " moved, swept" : " moved"));
+   pairs = move (found);
+   for (size_t index: dirty) stale[index] = 0;
+   dirty.clear();
+   return pairs;
+}
+
@@ -0,0 +1,58 @@
+// $Id: collision.h,v 1.1 2026-10-19 12:00:00-07 - - $
+
+//
+// collisions -
+//    Which objects overlap, once the collisions command or
+//    gdraw::track_collisions has asked for it.  The broad phase is
+//    sweep and prune on x: the objects are kept sorted by the left
+//    edge of their bounds, which are refreshed only for the objects
+//    window reports as moved, and those are merged back into the
+//    order in one pass over it.  Pairs of objects that have not
+//    moved are kept as they were; each object that has is looked up
+//    in the order, and only the pairs whose bounds overlap are
+//    tested exactly.  When many objects have moved, one sweep over
+//    all of them is cheaper and is done instead.  The exact test is
+//    on the polygon outlines, and on ellipses by scaling them to
+//    unit circles; an ellipse against another, not a circle, uses
+//    the other's outline.  Text counts as its bounds.
+//
+//    Overlapping objects are outlined in the border color, and
+//    each pair is printed as "collision i j" when it begins to
+//    overlap, with the objects numbered in drawing order.
+//
+
+#ifndef __COLLISION_H__
+#define __COLLISION_H__
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+using namespace std;
+
+#include "shape.h"
+
+class collisions {
+   public:
+      using pair_list = vector<pair<size_t,size_t>>; // Sorted.
+   private:
+      static bool tracking;
+      static vector<bbox> boxes;   // In world coordinates.
+      static vector<char> stale;   // Moved since the last update.
+      static vector<size_t> dirty; // The stale objects.
+      static GLfloat widest;       // Of any bounds, so far.
+      static vector<size_t> order; // By boxes[index].low.xpos.
+      static pair_list pairs;
+      static bool overlap (size_t first, size_t second);
+      static pair_list sweep();
+      static pair_list requery();
+   public:
+      collisions() = delete;
+      static void track() { tracking = true; }
+      static bool enabled() { return tracking; }
+      static void moved (size_t first, size_t last); // [first,last)
+      static void forget(); // The objects have been replaced.
+      static const pair_list& update();
+};
+
+#endif
+
@@ -1,7 +1,17 @@
-// $Id: debug.cpp,v 1.4 2018-01-25 16:04:38-08 - - $
+// $Id: debug.cpp,v 1.5 2026-10-19 12:00:00-07 - - $
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <climits>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <pthread.h>
+#include <thread>
+#include <unistd.h>
 #include <vector>
 
 using namespace std;
@@ -26,10 +36,229 @@ bool debugflags::getflag (char flag) {
    return flags.test (static_cast<unsigned char> (flag));
 }
 
-void debugflags::where (char flag, const char* file, int line,
-                        const char* pretty_function) {
-   cout << sys_info::execname() << ": DEBUG(" << flag << ") "
-        << file << "[" << line << "] " << endl
-        << "   " << pretty_function << endl;
+//
+// trace_ring -
+//    Fixed-size ring of trace records with one producer, the thread
+//    that owns it, and one consumer, whoever holds writer_lock.
+//
+
+namespace {
+
+using trace_clock = chrono::steady_clock;
+
+// Longer messages are cut off, so recording never allocates.
+constexpr size_t message_size = 224;
+
+struct trace_record {
+   trace_clock::time_point time;
+   char flag;
+   bool truncated;
+   const char* file;
+   int line;
+   const char* function;
+   size_t length;
+   char message[message_size];
+};
+
+// Formats into a fixed array, dropping what does not fit.
+class message_buffer: public streambuf {
+   private:
+      char text[message_size];
+      bool overflowed = false;
+   protected:
+      int_type overflow (int_type chr) override {
+         if (not traits_type::eq_int_type (chr, traits_type::eof())) {
+            overflowed = true;
+         }
+         return traits_type::not_eof (chr);
+      }
+   public:
+      message_buffer() { clear(); }
+      const char* data() const { return pbase(); }
+      size_t length() const { return pptr() - pbase(); }
+      bool truncated() const { return overflowed; }
+      void clear() {
+         setp (text, text + message_size);
+         overflowed = false;
+      }
+};
+
+class trace_ring {
+   private:
+      static constexpr size_t capacity = 4096;
+      array<trace_record,capacity> slots;
+      atomic<size_t> head {0}; // Next slot to write.
+      atomic<size_t> tail {0}; // Next slot to read.
+   public:
+      const size_t number;     // Which thread, in order of first trace.
+      atomic<size_t> dropped {0};
+      size_t reported {0};     // Drops already written out.
+      trace_ring (size_t number_): number (number_) {}
+      // Fill in the next slot in place, unless the ring is full.
+      template <typename func_t>
+      void push (func_t fill) {
+         size_t next = head.load (memory_order_relaxed);
+         if (next - tail.load (memory_order_acquire) == capacity) {
+            dropped.fetch_add (1, memory_order_relaxed);
+            return;
+         }
+         fill (slots[next % capacity]);
+         head.store (next + 1, memory_order_release);
+      }
+      template <typename func_t>
+      void drain (func_t func) {
+         size_t first = tail.load (memory_order_relaxed);
+         size_t last = head.load (memory_order_acquire);
+         for (size_t index = first; index != last; ++index) {
+            func (slots[index % capacity]);
+         }
+         tail.store (last, memory_order_release);
+      }
+};
+
+// Never destroyed, since the writer thread runs until the very end.
+struct trace_state {
+   mutex rings_lock;
+   vector<shared_ptr<trace_ring>> rings;
+   mutex writer_lock;
+   FILE* logfile = stderr;
+   atomic<pid_t> writer_pid {0}; // Process running the writer thread.
+   atomic<pid_t> pid {getpid()}; // This process, kept across forks.
+   const trace_clock::time_point start_time = trace_clock::now();
+};
+trace_state& state = *new trace_state;
+
+// Write everything recorded so far.  Caller holds writer_lock.
+void drain_rings() {
+   vector<shared_ptr<trace_ring>> current;
+   {
+      lock_guard<mutex> guard (state.rings_lock);
+      current = state.rings;
+   }
+   ostringstream out;
+   for (const auto& ring: current) {
+      ring->drain ([&out, &ring] (trace_record& record) {
+         chrono::duration<double> when = record.time - state.start_time;
+         out << sys_info::execname() << ": DEBUG(" << record.flag
+             << ") " << record.file << "[" << record.line << "] +"
+             << when.count() << "s thread " << ring->number << "\n"
+             << "   " << record.function << "\n";
+         if (record.length > 0) {
+            out.write (record.message, record.length);
+            if (record.truncated) out << "...";
+            out << "\n";
+         }
+      });
+      size_t dropped = ring->dropped.load (memory_order_relaxed);
+      if (dropped != ring->reported) {
+         out << sys_info::execname() << ": DEBUG: "
+             << dropped - ring->reported << " trace records dropped"
+             << " by thread " << ring->number << "\n";
+         ring->reported = dropped;
+      }
+   }
+   string text = out.str();
+   if (text.empty()) return;
+   fwrite (text.data(), 1, text.size(), state.logfile);
+   fflush (state.logfile);
+}
+
+void writer() {
+   for (;;) {
+      this_thread::sleep_for (chrono::milliseconds (10));
+      lock_guard<mutex> guard (state.writer_lock);
+      drain_rings();
+   }
+}
+
+// Hold both locks across fork, so a child never inherits one that
+// the writer thread had locked, and drain first, so a child does not
+// write its parent's records again.
+void fork_prepare() {
+   state.writer_lock.lock();
+   drain_rings();
+   state.rings_lock.lock();
+}
+
+void fork_release() {
+   state.rings_lock.unlock();
+   state.writer_lock.unlock();
+}
+
+void fork_child() {
+   state.pid = getpid();
+   fork_release();
+}
+
+// Start the writer thread in this process, which may be a child
+// forked after the parent had started its own.
+void start_writer() {
+   lock_guard<mutex> guard (state.writer_lock);
+   // A fork before the handlers were set up left the parent's pid.
+   state.pid = getpid();
+   if (state.writer_pid == state.pid) return;
+   if (state.writer_pid == 0) {
+      atexit (debugflags::flush);
+      pthread_atfork (fork_prepare, fork_release, fork_child);
+   }
+   state.writer_pid = state.pid.load();
+   thread (writer).detach();
+}
+
+trace_ring& this_ring() {
+   thread_local shared_ptr<trace_ring> ring;
+   if (ring == nullptr) {
+      lock_guard<mutex> guard (state.rings_lock);
+      ring = make_shared<trace_ring> (state.rings.size());
+      state.rings.push_back (ring);
+   }
+   return *ring;
+}
+
+} // namespace
+
+void debugflags::setlogfile (const string& filename) {
+   FILE* file = fopen (filename.c_str(), "w");
+   if (file == nullptr) {
+      syscall_error (filename);
+      return;
+   }
+   lock_guard<mutex> guard (state.writer_lock);
+   state.logfile = file;
+}
+
+namespace {
+   struct message_stream {
+      message_buffer text;
+      ostream out {&text};
+   };
+   thread_local message_stream message;
+}
+
+ostream& debugflags::buffer() {
+   return message.out;
+}
+
+void debugflags::record (char flag, const char* file, int line,
+                         const char* pretty_function) {
+   if (state.writer_pid != state.pid) start_writer();
+   message_buffer& text = message.text;
+   this_ring().push ([&] (trace_record& record) {
+      record.time = trace_clock::now();
+      record.flag = flag;
+      record.truncated = text.truncated();
+      record.file = file;
+      record.line = line;
+      record.function = pretty_function;
+      record.length = text.length();
+      memcpy (record.message, text.data(), record.length);
+   });
+   text.clear();
+   message.out.clear();
+}
+
+void debugflags::flush() {
+   lock_guard<mutex> guard (state.writer_lock);
+   drain_rings();
 }
 
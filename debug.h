@@ -5,6 +5,7 @@
 
 #include <bitset>
 #include <climits>
+#include <sstream>
 #include <string>
 using namespace std;
 
@@ -17,6 +18,17 @@ using namespace std;
 // getflag -
 //    Used by the DEBUGF macro to check to see if a flag has been set.
 //    Not to be called by user code.
+// setlogfile -
+//    Write traces to the named file instead of cerr.
+// buffer, record -
+//    Used by the DEBUGF macro.  The trace is formatted into a buffer
+//    kept by each thread, then recorded with a timestamp into that
+//    thread's ring of trace records.  A background thread writes the
+//    records out, so tracing does not wait for output.  If a ring is
+//    full the record is dropped, and the number dropped is reported.
+//    Messages longer than the buffer are cut off and end in "...".
+// flush -
+//    Write out all recorded traces now.  Done automatically at exit.
 
 class debugflags {
    private:
@@ -25,8 +37,11 @@ class debugflags {
    public:
       static void setflags (const string& optflags);
       static bool getflag (char flag);
-      static void where (char flag, const char* file, int line,
-                         const char* pretty_function);
+      static void setlogfile (const string& filename);
+      static ostream& buffer();
+      static void record (char flag, const char* file, int line,
+                          const char* pretty_function);
+      static void flush();
 };
 
 
@@ -38,6 +53,7 @@ class debugflags {
 //       DEBUGF ('u', "foo = " << foo);
 //    will print two words and a newline if flag 'u' is  on.
 //    Traces are preceded by filename, line number, and function.
+//    DEBUGS records where it is, then runs the statement directly.
 
 #ifdef NDEBUG
 #define DEBUGF(FLAG,CODE) ;
@@ -45,15 +61,15 @@ class debugflags {
 #else
 #define DEBUGF(FLAG,CODE) { \
            if (debugflags::getflag (FLAG)) { \
-              debugflags::where (FLAG, __FILE__, __LINE__, \
-                                 __PRETTY_FUNCTION__); \
-              cerr << CODE << endl; \
+              debugflags::buffer() << CODE; \
+              debugflags::record (FLAG, __FILE__, __LINE__, \
+                                  __PRETTY_FUNCTION__); \
            } \
         }
 #define DEBUGS(FLAG,STMT) { \
            if (debugflags::getflag (FLAG)) { \
-              debugflags::where (FLAG, __FILE__, __LINE__, \
-                                 __PRETTY_FUNCTION__); \
+              debugflags::record (FLAG, __FILE__, __LINE__, \
+                                  __PRETTY_FUNCTION__); \
               STMT; \
            } \
         }
@@ -0,0 +1,108 @@
+// $Id: feed.cpp,v 1.1 2026-10-19 12:00:00-07 - - $
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+#include <GL/freeglut.h>
+
+#include "debug.h"
+#include "feed.h"
+#include "graphics.h"
+#include "util.h"
+
+feed_header* position_feed::header {nullptr};
+size_t position_feed::mapped_bytes {0};
+uint32_t position_feed::capacity {0};
+uint64_t position_feed::applied {0};
+vector<feed_entry> position_feed::snapshot;
+size_t position_feed::updates {0};
+size_t position_feed::retries {0};
+
+static const unsigned poll_msecs = 4;
+static const int read_attempts = 8; // Then wait for the next poll.
+
+bool position_feed::open (const string& name) {
+   int fd = shm_open (name.c_str(), O_RDONLY, 0);
+   if (fd < 0) {
+      syscall_error (name);
+      return false;
+   }
+   struct stat status;
+   if (fstat (fd, &status) < 0) {
+      syscall_error (name);
+      ::close (fd);
+      return false;
+   }
+   mapped_bytes = status.st_size;
+   void* mapped = mapped_bytes < sizeof (feed_header) ? MAP_FAILED
+                : mmap (nullptr, mapped_bytes, PROT_READ, MAP_SHARED,
+                        fd, 0);
+   ::close (fd);
+   if (mapped == MAP_FAILED) {
+      complain() << name << ": cannot map feed" << endl;
+      return false;
+   }
+   header = static_cast<feed_header*> (mapped);
+   bool magic_ok = memcmp (header->magic, feed_magic,
+                           sizeof feed_magic) == 0;
+   atomic_thread_fence (memory_order_acquire);
+   // The producer can rewrite the header at any time, so the capacity
+   // is read once and only that value is trusted afterward.
+   capacity = header->capacity;
+   if (not magic_ok or header->version != feed_version
+       or feed_bytes (capacity) > mapped_bytes) {
+      complain() << name << ": not a version " << feed_version
+                 << " feed" << endl;
+      munmap (mapped, mapped_bytes);
+      header = nullptr;
+      return false;
+   }
+   snapshot.reserve (capacity);
+   DEBUGF ('F', name << ": " << capacity << " entries");
+   window::add_timer (poll_msecs, poll);
+   return true;
+}
+
+// Copy out the latest update if there is a new one and it was not
+// being written while it was copied.
+bool position_feed::read() {
+   for (int attempt = 0; attempt < read_attempts; ++attempt) {
+      uint64_t before = header->sequence.load (memory_order_acquire);
+      if (before == applied) return false;
+      if (before % 2 != 0) {
+         ++retries;
+         continue;
+      }
+      uint32_t count = min (header->count, capacity);
+      snapshot.resize (count);
+      memcpy (snapshot.data(), feed_entries (header),
+              count * sizeof (feed_entry));
+      atomic_thread_fence (memory_order_acquire);
+      if (header->sequence.load (memory_order_relaxed) == before) {
+         applied = before;
+         return true;
+      }
+      ++retries;
+   }
+   return false;
+}
+
+void position_feed::poll (int) {
+   if (read()) {
+      for (const feed_entry& entry: snapshot) {
+         window::update_object (entry.index, {entry.xpos, entry.ypos},
+                                rgbcolor (entry.rgb[0], entry.rgb[1],
+                                          entry.rgb[2]));
+      }
+      window::invalidate();
+      glutPostRedisplay();
+      ++updates;
+      DEBUGF ('F', "update " << updates << ", " << snapshot.size()
+              << " entries, " << retries << " retries so far");
+   }
+   glutTimerFunc (poll_msecs, poll, 0);
+}
+
@@ -0,0 +1,86 @@
+// $Id: feed.h,v 1.1 2026-10-19 12:00:00-07 - - $
+
+//
+// position_feed -
+//    Object positions and colors driven by another process through
+//    a POSIX shared memory segment, given by --feed=/name.  The
+//    segment is a header followed by an array of entries, each
+//    naming an object by its index in drawing order.  The producer
+//    writes under a seqlock: it makes the sequence odd, writes the
+//    count and the entries, then makes it even again.  A timer in
+//    the window copies the entries out whenever the sequence has
+//    moved on, retrying if it changed during the copy, and writes
+//    them straight into the objects, with no text in between.
+//    gdfeed, built alongside gdraw, is a test producer.
+//
+
+#ifndef __FEED_H__
+#define __FEED_H__
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+using namespace std;
+
+struct feed_header {
+   char magic[8];              // feed_magic.
+   uint32_t version;           // feed_version.
+   uint32_t capacity;          // Entries the segment has room for.
+   atomic<uint64_t> sequence;  // Odd while being written.
+   uint32_t count;             // Entries in the latest update.
+   uint32_t unused;
+};
+
+struct feed_entry {
+   uint32_t index;             // Of the object in the window.
+   float xpos;
+   float ypos;
+   uint8_t rgb[3];
+   uint8_t unused;
+};
+
+static_assert (atomic<uint64_t>::is_always_lock_free,
+               "the sequence must work between processes");
+
+constexpr char feed_magic[8] {'G', 'D', 'F', 'E', 'E', 'D', '0', '1'};
+constexpr uint32_t feed_version = 1;
+
+inline size_t feed_bytes (uint32_t capacity) {
+   return sizeof (feed_header) + capacity * sizeof (feed_entry);
+}
+
+inline feed_entry* feed_entries (feed_header* header) {
+   return reinterpret_cast<feed_entry*> (header + 1);
+}
+
+// The producer's side of the seqlock.  There must be one producer.
+inline void feed_publish (feed_header* header,
+                          const feed_entry* entries, uint32_t count) {
+   uint64_t sequence = header->sequence.load (memory_order_relaxed);
+   header->sequence.store (sequence + 1, memory_order_relaxed);
+   atomic_thread_fence (memory_order_release);
+   header->count = count;
+   memcpy (feed_entries (header), entries, count * sizeof (feed_entry));
+   header->sequence.store (sequence + 2, memory_order_release);
+}
+
+class position_feed {
+   private:
+      static feed_header* header;
+      static size_t mapped_bytes;
+      static uint32_t capacity;    // As checked against mapped_bytes.
+      static uint64_t applied;     // Sequence of the last update.
+      static vector<feed_entry> snapshot;
+      static size_t updates;
+      static size_t retries;
+      static bool read();
+      static void poll (int);
+   public:
+      position_feed() = delete;
+      static bool open (const string& name);
+};
+
+#endif
+
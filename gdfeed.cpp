@@ -0,0 +1,103 @@
+// $Id: gdfeed.cpp,v 1.1 2026-10-19 12:00:00-07 - - $
+
+//
+// gdfeed -
+//    Test producer for gdraw --feed, for benchmarking.  Creates the
+//    shared memory segment, then moves the first count objects
+//    around circles, publishing rate updates a second for the given
+//    number of seconds.  Prints how many updates were published and
+//    how long publishing took, and removes the segment.
+//    Usage: gdfeed /name count [rate [seconds]]
+//
+
+#include <chrono>
+#include <cmath>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+using namespace std;
+
+#include "feed.h"
+#include "util.h"
+
+// A new segment every time, even if one was left by an earlier run,
+// so a reader never sees an old sequence or entries.  The magic is
+// written last, so a reader that finds it finds the rest as well.
+static feed_header* create (const string& name, uint32_t capacity) {
+   shm_unlink (name.c_str());
+   int fd = shm_open (name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666);
+   if (fd < 0) {
+      syscall_error (name);
+      return nullptr;
+   }
+   void* mapped = MAP_FAILED;
+   if (ftruncate (fd, feed_bytes (capacity)) == 0) {
+      mapped = mmap (nullptr, feed_bytes (capacity),
+                     PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   }
+   if (mapped == MAP_FAILED) syscall_error (name);
+   close (fd);
+   if (mapped == MAP_FAILED) return nullptr;
+   feed_header* header = static_cast<feed_header*> (mapped);
+   header->version = feed_version;
+   header->capacity = capacity;
+   header->count = 0;
+   header->sequence.store (0, memory_order_relaxed);
+   atomic_thread_fence (memory_order_release);
+   memcpy (header->magic, feed_magic, sizeof feed_magic);
+   return header;
+}
+
+int main (int argc, char** argv) {
+   sys_info::execname (argv[0]);
+   if (argc < 3 or argc > 5) {
+      cerr << "Usage: " << sys_info::execname()
+           << " /name count [rate [seconds]]" << endl;
+      return EXIT_FAILURE;
+   }
+   string name = argv[1];
+   uint32_t count = stoul (argv[2]);
+   double rate = argc > 3 ? stod (argv[3]) : 1000;
+   double seconds = argc > 4 ? stod (argv[4]) : 10;
+   feed_header* header = create (name, count);
+   if (header == nullptr) return EXIT_FAILURE;
+
+   using clock = chrono::steady_clock;
+   vector<feed_entry> entries (count);
+   chrono::duration<double> period (1 / rate);
+   clock::time_point start = clock::now();
+   double publish_us = 0;
+   double max_us = 0;
+   size_t updates = 0;
+   for (; updates < rate * seconds; ++updates) {
+      double turn = updates / rate / 4; // A quarter turn a second.
+      for (uint32_t index = 0; index < count; ++index) {
+         double angle = 2 * M_PI * (turn + double (index) / count);
+         double radius = 50 + 150 * (index % 4) / 3.0;
+         entries[index] = {index, float (320 + radius * cos (angle)),
+                           float (240 + radius * sin (angle)),
+                           {uint8_t (128 + 127 * cos (angle)),
+                            uint8_t (128 + 127 * sin (angle)), 255},
+                           0};
+      }
+      clock::time_point before = clock::now();
+      feed_publish (header, entries.data(), count);
+      chrono::duration<double,micro> took = clock::now() - before;
+      publish_us += took.count();
+      max_us = max (max_us, took.count());
+      this_thread::sleep_until (start + (updates + 1)
+                  * chrono::duration_cast<clock::duration> (period));
+   }
+   chrono::duration<double> elapsed = clock::now() - start;
+   cout << updates << " updates of " << count << " in "
+        << elapsed.count() << " s, publish mean "
+        << (updates > 0 ? publish_us / updates : 0) << " us, max "
+        << max_us << " us" << endl;
+   munmap (header, feed_bytes (count));
+   shm_unlink (name.c_str());
+   return EXIT_SUCCESS;
+}
+
@@ -1,23 +1,41 @@
 // $Id: graphics.cpp,v 1.4 2019-02-28 15:24:20-08 - - $
 
+// Must precede the first GL header to declare glWindowPos2i.
+#define GL_GLEXT_PROTOTYPES
+
+#include <algorithm>
 #include <iostream>
 using namespace std;
 
 #include <GL/freeglut.h>
 #include <cmath> // remove
 
+#include "capture.h"
+#include "collision.h"
 #include "graphics.h"
+#include "hud.h"
+#include "input.h"
+#include "layer.h"
+#include "paged.h"
+#include "shader.h"
 #include "util.h"
 
 int window::width = 640; // in pixels
 int window::height = 480; // in pixels
 GLfloat window::thickness = 0;
 GLfloat window::move_by = 4;
+vertex window::origin {0, 0};
 bool window::selected {false};
 rgbcolor window::border_color;
 vector<object> window::objects;
+vector<group> window::groups;
+vector<size_t> window::open_groups;
 size_t window::selected_obj = 0;
+size_t window::selected_group = no_group;
+render_queue window::queue;
+pair<size_t,size_t> window::queue_moving {0, 0};
 mouse window::mus;
+vector<pair<unsigned,window::timer_fn>> window::timers;
 
 // Executed when window system signals to shut down.
 void window::close() {
@@ -39,19 +57,316 @@ void window::entry (int mouse_entered) {
 
 // Called to display the objects in the window.
 void window::display() {
+   hud::begin_frame();
    glClear (GL_COLOR_BUFFER_BIT);
 
-   // draw border of selected object
-   objects.at(selected_obj).draw();
+   vector<vertex> offsets = group_offsets();
+   auto offset_of = [&offsets] (const object& obj) {
+      return obj.get_group() == no_group ? vertex {0, 0}
+                                         : offsets[obj.get_group()];
+   };
+   bbox view {origin, {origin.xpos + width, origin.ypos + height}};
+
+   // queue the objects that do not move with the keys apart from
+   // those that do, which are drawn over them, so that moving them
+   // leaves the queue as it is
+   pair<size_t,size_t> moving = moving_range();
+   bool rebuilt = not queue.is_valid() or moving != queue_moving;
+   if (rebuilt) {
+      vector<render_queue::item> visible;
+      visit (view, offsets, [&] (size_t index) {
+         if (index >= moving.first and index < moving.second) return;
+         visible.push_back ({index, offset_of (objects[index])});
+      });
+      queue.build (objects, visible, view);
+      queue_moving = moving;
+   }
+
+   // draw the objects that do not move from the layer, redrawing it
+   // first if they have changed
+   bool layered = layer_cache::enabled();
+   if (layered and (rebuilt or not layer_cache::is_valid())) {
+      layer_cache::begin (width, height);
+      queue.submit (objects);
+      layer_cache::end();
+   }
+   // the framebuffer may have failed, leaving everything to draw
+   layered = layer_cache::enabled();
+   if (layered) layer_cache::draw (origin.xpos, origin.ypos);
+
+   // outline the objects that overlap others
+   if (collisions::enabled()) {
+      vector<size_t> overlapping;
+      for (const auto& each: collisions::update()) {
+         overlapping.push_back (each.first);
+         overlapping.push_back (each.second);
+      }
+      sort (overlapping.begin(), overlapping.end());
+      auto end = unique (overlapping.begin(), overlapping.end());
+      overlapping.erase (end, overlapping.end());
+      for (size_t index: overlapping) {
+         objects[index].draw_border (offset_of (objects[index]),
+                                     border_color, thickness);
+      }
+   }
+
+   // draw border of selected object under the objects
+   if (selected and selected_obj < objects.size()) {
+      object& obj = objects[selected_obj];
+      if (ellipse_shader::enabled()
+          and obj.get_shape().kind() == primitive::ELLIPSE) {
+         vertex center = obj.get_pos();
+         center.xpos += offset_of (obj).xpos;
+         center.ypos += offset_of (obj).ypos;
+         ellipse_shader::ring (center, obj.get_shape().bounds().high,
+                               border_color, thickness);
+      }else {
+         obj.draw_border (offset_of (obj), border_color, thickness);
+      }
+   }
 
-   // draw rest of objects
+   // draw the objects in view, batched by color, unless the layer
+   // has them, then the moving ones over them
    selected = false;
-   for (auto& object: window::objects) {
-      object.draw();
+   if (not layered) queue.submit (objects);
+   vector<render_queue::item> movers;
+   for (size_t index = moving.first; index < moving.second; ++index) {
+      movers.push_back ({index, offset_of (objects[index])});
    }
+   render_queue moving_queue;
+   moving_queue.build (objects, movers, view);
+   moving_queue.submit (objects);
+   size_t drawn = queue.size() + moving_queue.size();
+   if (paged_scene::active()) paged_scene::draw (view);
+   hud::end_frame (drawn, objects.size() - drawn);
 
    mus.draw();
+   hud::draw (height);
+   frame_capture::frame_drawn (width, height);
    glutSwapBuffers();
+   hud::presented();
+   input_log::presented();
+}
+
+// Build cached geometry for every object without touching GL.
+void window::prepare() {
+   for (auto& object: window::objects) object.prepare (thickness);
+}
+
+// The objects overlapping each tile of a grid over area, row by row
+// from the bottom left, in drawing order, found in one pass over the
+// objects.
+window::tile_list window::tiles (const bbox& area, GLfloat tile_size,
+                                 size_t columns, size_t rows) {
+   tile_list result (columns * rows);
+   if (result.empty()) return result;
+   vector<vertex> offsets = group_offsets();
+   // Tiles that bounds from low to high overlap, counting those they
+   // only touch, as bbox::overlaps does.
+   auto tile_range = [tile_size] (GLfloat low, GLfloat high,
+                                  size_t count) {
+      GLfloat first = ceil (low / tile_size) - 1;
+      GLfloat last = floor (high / tile_size);
+      return make_pair (first > 0 ? min (size_t (first), count - 1) : 0,
+                        last > 0 ? min (size_t (last), count - 1) : 0);
+   };
+   visit (area, offsets, [&] (size_t index) {
+      size_t group = objects[index].get_group();
+      vertex offset = group == no_group ? vertex {0, 0}
+                                        : offsets[group];
+      bbox box = objects[index].bounds() + offset;
+      auto xrange = tile_range (box.low.xpos - area.low.xpos,
+                                box.high.xpos - area.low.xpos, columns);
+      auto yrange = tile_range (box.low.ypos - area.low.ypos,
+                                box.high.ypos - area.low.ypos, rows);
+      for (size_t row = yrange.first; row <= yrange.second; ++row) {
+         for (size_t column = xrange.first; column <= xrange.second;
+              ++column) {
+            result[row * columns + column].push_back ({index, offset});
+         }
+      }
+   });
+   return result;
+}
+
+// Draw the objects of one tile, as found by tiles, without the
+// selection or the overlays, into whatever projection the caller
+// has set up for area.
+void window::draw_area (const vector<render_queue::item>& tile,
+                        const bbox& area) {
+   render_queue area_queue;
+   area_queue.build (objects, tile, area);
+   area_queue.submit (objects);
+}
+
+// Forget all objects, as before a new scene is loaded.
+void window::clear() {
+   queue.invalidate();
+   collisions::forget();
+   objects.clear();
+   groups.clear();
+   open_groups.clear();
+   selected_obj = 0;
+   selected_group = no_group;
+   selected = false;
+}
+
+void window::begin_group (const string& name) {
+   DEBUGF ('g', name << " at " << objects.size());
+   size_t parent = open_groups.empty() ? no_group : open_groups.back();
+   groups.push_back ({name, parent, objects.size(), objects.size()});
+   open_groups.push_back (groups.size() - 1);
+}
+
+void window::end_group() {
+   if (open_groups.empty()) throw runtime_error ("no group to end");
+   groups[open_groups.back()].last = objects.size();
+   open_groups.pop_back();
+}
+
+// End any groups left open at the end of a file, returning how many.
+size_t window::close_groups() {
+   size_t count = open_groups.size();
+   while (not open_groups.empty()) end_group();
+   return count;
+}
+
+// A group and all of the groups containing it need new bounds.
+void window::mark_dirty (size_t group) {
+   for (; group != no_group; group = groups[group].parent) {
+      groups[group].dirty = true;
+   }
+}
+
+const bbox& window::group_bounds (size_t index) {
+   group& grp = groups[index];
+   if (grp.dirty) {
+      grp.bounds = {};
+      for (size_t obj = grp.first; obj < grp.last; ++obj) {
+         if (objects[obj].get_group() == index) {
+            grp.bounds.merge (objects[obj].bounds());
+         }
+      }
+      for (size_t child = index + 1; child < groups.size()
+           and groups[child].first <= grp.last; ++child) {
+         if (groups[child].parent != index) continue;
+         grp.bounds.merge (group_bounds (child) + groups[child].offset);
+      }
+      grp.dirty = false;
+   }
+   return grp.bounds;
+}
+
+// Total offset of a group and everything containing it.
+vertex window::group_offset (size_t group) {
+   vertex offset {0, 0};
+   for (; group != no_group; group = groups[group].parent) {
+      offset.xpos += groups[group].offset.xpos;
+      offset.ypos += groups[group].offset.ypos;
+   }
+   return offset;
+}
+
+// Total offsets of all groups.  Parents precede their children.
+vector<vertex> window::group_offsets() {
+   vector<vertex> offsets (groups.size());
+   for (size_t index = 0; index < groups.size(); ++index) {
+      offsets[index] = groups[index].offset;
+      size_t parent = groups[index].parent;
+      if (parent == no_group) continue;
+      offsets[index].xpos += offsets[parent].xpos;
+      offsets[index].ypos += offsets[parent].ypos;
+   }
+   return offsets;
+}
+
+// Call func, in drawing order, for each object whose bounds overlap
+// area, skipping groups whose bounds do not.
+void window::visit (const bbox& area, const vector<vertex>& offsets,
+                    const function<void (size_t)>& func) {
+   size_t next_group = 0;
+   for (size_t index = 0; index < objects.size();) {
+      bool skipped = false;
+      while (next_group < groups.size()
+             and groups[next_group].first == index) {
+         size_t current = next_group++;
+         const group& grp = groups[current];
+         if (grp.first == grp.last
+             or (group_bounds (current) + offsets[current])
+                .overlaps (area)) continue;
+         while (next_group < groups.size()
+                and groups[next_group].first < grp.last) ++next_group;
+         index = grp.last;
+         skipped = true;
+         break;
+      }
+      if (skipped) continue;
+      const object& obj = objects[index];
+      vertex offset = obj.get_group() == no_group ? vertex {0, 0}
+                    : offsets[obj.get_group()];
+      if ((obj.bounds() + offset).overlaps (area)) func (index);
+      ++index;
+   }
+}
+
+// The objects that move with the keys: the selected group, or else
+// the selected object.
+pair<size_t,size_t> window::moving_range() {
+   if (selected_group != no_group) {
+      return {groups[selected_group].first, groups[selected_group].last};
+   }
+   if (selected_obj < objects.size()) {
+      return {selected_obj, selected_obj + 1};
+   }
+   return {0, 0};
+}
+
+// The topmost object under a window position, or no_object if none.
+size_t window::pick (int x, int y) {
+   vertex point {origin.xpos + x, origin.ypos + height - y};
+   size_t found = no_object;
+   visit ({point, point}, group_offsets(), [&found] (size_t index) {
+      found = index;
+   });
+   return found;
+}
+
+// Replace objects [first,last) with others, keeping the selection on
+// the same object when it lies outside the replaced range.
+void window::splice (size_t first, size_t last,
+                     vector<object>&& replacement) {
+   DEBUGF ('g', "[" << first << "," << last << ") <- "
+           << replacement.size());
+   queue.invalidate();
+   size_t added = replacement.size();
+   if (added == last - first) {
+      move (replacement.begin(), replacement.end(),
+            objects.begin() + first);
+      collisions::moved (first, last);
+   }else {
+      objects.erase (objects.begin() + first, objects.begin() + last);
+      objects.insert (objects.begin() + first,
+                      make_move_iterator (replacement.begin()),
+                      make_move_iterator (replacement.end()));
+   }
+   if (selected_obj >= last) {
+      selected_obj = selected_obj - (last - first) + added;
+   }else if (selected_obj >= first + added) {
+      selected_obj = added > 0 ? first + added - 1 : first;
+   }
+   if (selected_obj >= objects.size()) selected_obj = 0;
+}
+
+// Indices past the last object are ignored.  The caller invalidates
+// the queue once for a whole batch.
+void window::update_object (size_t index, const vertex& center,
+                            const rgbcolor& color) {
+   if (index >= objects.size()) return;
+   object& obj = objects[index];
+   obj.set_pos (center.xpos, center.ypos);
+   obj.set_color (color);
+   mark_dirty (obj.get_group());
+   collisions::moved (index, index + 1);
 }
 
 // Called when window is opened and when resized.
@@ -59,64 +374,109 @@ void window::reshape (int width, int height) {
    DEBUGF ('g', "width=" << width << ", height=" << height);
    window::width = width;
    window::height = height;
-   glMatrixMode (GL_PROJECTION);
-   glLoadIdentity();
-   gluOrtho2D (0, window::width, 0, window::height);
-   glMatrixMode (GL_MODELVIEW);
+   queue.invalidate();
+   set_projection();
    glViewport (0, 0, window::width, window::height);
    glClearColor (0.25, 0.25, 0.25, 1.0);
    glutPostRedisplay();
 }
+
+// The window shows the scene from origin up and to the right.
+void window::set_projection() {
+   glMatrixMode (GL_PROJECTION);
+   glLoadIdentity();
+   gluOrtho2D (origin.xpos, origin.xpos + width,
+               origin.ypos, origin.ypos + height);
+   glMatrixMode (GL_MODELVIEW);
+   text::set_window_origin (origin);
+}
+
+void window::pan (GLfloat delta_x, GLfloat delta_y) {
+   origin.xpos += delta_x;
+   origin.ypos += delta_y;
+   DEBUGF ('g', "origin=" << origin.xpos << "," << origin.ypos);
+   queue.invalidate();
+   set_projection();
+}
 
+// Move the selected object, wrapping around when it goes more than
+// 50 pixels off any edge of the view.  If a group is selected,
+// move the group instead.
+void window::move_selected (GLfloat delta_x, GLfloat delta_y) {
+   if (selected_obj >= objects.size()) return;
+   // The queue leaves out what moves, so it stays as it is.
+   if (selected_group != no_group) {
+      groups[selected_group].offset.xpos += delta_x;
+      groups[selected_group].offset.ypos += delta_y;
+      mark_dirty (groups[selected_group].parent);
+      collisions::moved (groups[selected_group].first,
+                         groups[selected_group].last);
+      return;
+   }
+   object& obj = objects[selected_obj];
+   vertex offset = group_offset (obj.get_group());
+   obj.move (delta_x, delta_y);
+   vertex pos = obj.get_pos();
+   GLfloat xpos = pos.xpos + offset.xpos - origin.xpos;
+   if (xpos < -50) {
+      obj.set_pos (origin.xpos + width - offset.xpos, pos.ypos);
+   }
+   if (xpos > width + 50) {
+      obj.set_pos (origin.xpos - offset.xpos, pos.ypos);
+   }
+   pos = obj.get_pos();
+   GLfloat ypos = pos.ypos + offset.ypos - origin.ypos;
+   if (ypos < -50) {
+      obj.set_pos (pos.xpos, origin.ypos + height - offset.ypos);
+   }
+   if (ypos > height + 50) {
+      obj.set_pos (pos.xpos, origin.ypos - offset.ypos);
+   }
+   mark_dirty (obj.get_group());
+   collisions::moved (selected_obj, selected_obj + 1);
+}
+
 // Executed when a regular keyboard key is pressed.
 void window::keyboard (GLubyte key, int x, int y) {
    enum {BS = 8, TAB = 9, ESC = 27, SPACE = 32, DEL = 127};
    DEBUGF ('g', "key=" << unsigned (key) << ", x=" << x << ", y=" << y);
+   hud::input();
+   input_log::note (input_log::KEY, key, 0, x, y);
    window::mus.set (x, y);
    selected = true;
+   size_t previous = selected_obj;
    switch (key) {
       case 'Q': case 'q': case ESC:
          window::close();
          break;
-      case 'H': case 'h':
-         // move_selected_object left
-         objects.at(selected_obj).move(-move_by,0.0);
-
-         // reset position if moved off screen
-         if(objects.at(selected_obj).get_pos().xpos < -50) {
-            objects.at(selected_obj).set_pos(width, 
-                  objects.at(selected_obj).get_pos().ypos);
+      case 'F': case 'f':
+         hud::toggle();
+         break;
+      case 'G': case 'g':
+         // select the next enclosing group, then the object again
+         if (selected_obj >= objects.size()) break;
+         selected_group = selected_group == no_group
+                        ? objects[selected_obj].get_group()
+                        : groups[selected_group].parent;
+         if (selected_group != no_group) {
+            cerr << "Group " << groups[selected_group].name
+                 << " selected" << endl;
          }
          break;
+      case 'H': case 'h':
+         move_selected (-move_by, 0);
+         break;
       case 'J': case 'j':
-         //move_selected_object down
-         objects.at(selected_obj).move(0.0,-move_by);
-
-         // reset position if moved off screen
-         if(objects.at(selected_obj).get_pos().ypos > height+50) {
-            objects.at(selected_obj).set_pos(
-                  objects.at(selected_obj).get_pos().xpos, 0);
-         }
+         move_selected (0, -move_by);
          break;
       case 'K': case 'k':
-         //move_selected_object up
-         objects.at(selected_obj).move(0.0, move_by);
-
-         // reset position if moved off screen
-         if(objects.at(selected_obj).get_pos().ypos < -50) {
-            objects.at(selected_obj).set_pos(
-                  objects.at(selected_obj).get_pos().xpos, height);
-         }         
+         move_selected (0, move_by);
          break;
       case 'L': case 'l':
-         // move_selected_object right
-         objects.at(selected_obj).move(move_by,0.0);
-
-         // reset position if moved off screen
-         if(objects.at(selected_obj).get_pos().xpos > width+50) {
-            objects.at(selected_obj).set_pos(0, 
-                  objects.at(selected_obj).get_pos().ypos);
-         }
+         move_selected (move_by, 0);
+         break;
+      case 'S': case 's':
+         frame_capture::request();
          break;
       case 'N': case 'n': case SPACE: case TAB:
          if(selected_obj == objects.size()-1) {
@@ -150,54 +510,41 @@ void window::keyboard (GLubyte key, int x, int y) {
          cerr << unsigned (key) << ": invalid keystroke" << endl;
          break;
    }
+   if (selected_obj != previous) selected_group = no_group;
    glutPostRedisplay();
 }
 
 // Executed when a special function key is pressed.
 void window::special (int key, int x, int y) {
    DEBUGF ('g', "key=" << key << ", x=" << x << ", y=" << y);
+   hud::input();
+   input_log::note (input_log::SPECIAL, key, 0, x, y);
    window::mus.set (x, y);
    selected = true;
+   size_t previous = selected_obj;
+   // with shift, the arrows pan the view by a quarter window
+   bool panning = input_log::modifiers() & GLUT_ACTIVE_SHIFT;
+   GLfloat step_x = width / 4;
+   GLfloat step_y = height / 4;
    switch (key) {
       case GLUT_KEY_LEFT: 
-         // move_selected_object left
-         objects.at(selected_obj).move(-move_by,0.0);
-
-         // reset position if moved off screen
-         if(objects.at(selected_obj).get_pos().xpos < -50) {
-            objects.at(selected_obj).set_pos(width, 
-                  objects.at(selected_obj).get_pos().ypos);
-         }
+         if (panning) pan (-step_x, 0);
+                 else move_selected (-move_by, 0);
          break;
       case GLUT_KEY_DOWN: 
-         //move_selected_object down
-         objects.at(selected_obj).move(0.0,-move_by);
-
-         // reset position if moved off screen
-         if(objects.at(selected_obj).get_pos().ypos > height+50) {
-            objects.at(selected_obj).set_pos(
-                  objects.at(selected_obj).get_pos().xpos, 0);
-         }
+         if (panning) pan (0, -step_y);
+                 else move_selected (0, -move_by);
          break;
       case GLUT_KEY_UP: 
-         //move_selected_object up
-         objects.at(selected_obj).move(0.0, move_by);
-
-         // reset position if moved off screen
-         if(objects.at(selected_obj).get_pos().ypos < -50) {
-            objects.at(selected_obj).set_pos(
-                  objects.at(selected_obj).get_pos().xpos, height);
-         }    
+         if (panning) pan (0, step_y);
+                 else move_selected (0, move_by);
          break;
       case GLUT_KEY_RIGHT: 
-         // move_selected_object right
-         objects.at(selected_obj).move(move_by,0.0);
-
-         // reset position if moved off screen
-         if(objects.at(selected_obj).get_pos().xpos > width+50) {
-            objects.at(selected_obj).set_pos(0, 
-                  objects.at(selected_obj).get_pos().ypos);
-         }
+         if (panning) pan (step_x, 0);
+                 else move_selected (move_by, 0);
+         break;
+      case GLUT_KEY_HOME:
+         pan (-origin.xpos, -origin.ypos);
          break;
       case GLUT_KEY_F1: 
          // convert to size_t digit and select_object 1
@@ -335,18 +682,22 @@ void window::special (int key, int x, int y) {
          cerr << unsigned (key) << ": invalid function key" << endl;
          break;
    }
+   if (selected_obj != previous) selected_group = no_group;
    glutPostRedisplay();
 }
 
 
 void window::motion (int x, int y) {
    DEBUGF ('g', "x=" << x << ", y=" << y);
+   hud::input();
+   input_log::note (input_log::MOTION, 0, 0, x, y);
    window::mus.set (x, y);
    glutPostRedisplay();
 }
 
 void window::passivemotion (int x, int y) {
    DEBUGF ('g', "x=" << x << ", y=" << y);
+   input_log::note (input_log::PASSIVE, 0, 0, x, y);
    window::mus.set (x, y);
    glutPostRedisplay();
 }
@@ -354,8 +705,18 @@ void window::passivemotion (int x, int y) {
 void window::mousefn (int button, int state, int x, int y) {
    DEBUGF ('g', "button=" << button << ", state=" << state
            << ", x=" << x << ", y=" << y);
+   hud::input();
+   input_log::note (input_log::MOUSE, button, state, x, y);
    window::mus.state (button, state);
    window::mus.set (x, y);
+   if (button == GLUT_LEFT_BUTTON and state == GLUT_DOWN) {
+      size_t picked = pick (x, y);
+      if (picked != no_object) {
+         if (picked != selected_obj) selected_group = no_group;
+         selected_obj = picked;
+         selected = true;
+      }
+   }
    glutPostRedisplay();
 }
 
@@ -375,6 +736,12 @@ void window::main () {
    glutMotionFunc (window::motion);
    glutPassiveMotionFunc (window::passivemotion);
    glutMouseFunc (window::mousefn);
+   ellipse_shader::init();
+   layer_cache::init();
+   frame_capture::init();
+   for (const auto& timer: timers) {
+      glutTimerFunc (timer.first, timer.second, 0);
+   }
    DEBUGF ('g', "Calling glutMainLoop()");
    glutMainLoop();
 }
@@ -398,7 +765,7 @@ void mouse::draw() {
    if (entered == GLUT_ENTERED) {
       void* font = GLUT_BITMAP_HELVETICA_18;
       glColor3ubv (color.ubvec);
-      glRasterPos2i (10, 10);
+      glWindowPos2i (10, 10);
       auto ubytes = reinterpret_cast<const GLubyte*>
                     (text.str().c_str());
       glutBitmapString (font, ubytes);
@@ -3,34 +3,82 @@
 #ifndef __GRAPHICS_H__
 #define __GRAPHICS_H__
 
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 using namespace std;
 
 #include <GL/freeglut.h>
 
+#include "render.h"
 #include "rgbcolor.h"
 #include "shape.h"
 
+constexpr size_t no_group = SIZE_MAX;
+constexpr size_t no_object = SIZE_MAX;
+
+//
+// An object's center is relative to the offsets of the groups
+// containing it, which are added in when it is drawn.
+//
+
 class object {
    private:
       shared_ptr<shape> pshape;
       vertex center;
       rgbcolor color;
+      size_t group {no_group}; // Innermost group containing this.
    public:
       // Default copiers, movers, dtor all OK.
-      void draw() { pshape->draw (center, color); }
+      void draw (const vertex& offset) {
+         pshape->draw ({center.xpos + offset.xpos,
+                        center.ypos + offset.ypos}, color);
+      }
+      void prepare (GLfloat thickness) { pshape->prepare (thickness); }
+      void draw_border (const vertex& offset, const rgbcolor& border,
+                        GLfloat thickness) {
+         pshape->draw_border ({center.xpos + offset.xpos,
+                               center.ypos + offset.ypos},
+                              border, thickness);
+      }
+      bbox bounds() const { return pshape->bounds() + center; }
+      const shape& get_shape() const { return *pshape; }
+      const rgbcolor& get_color() const { return color; }
+      size_t get_group() const { return group; }
+      void set_group (size_t group_) { group = group_; }
       void move (GLfloat delta_x, GLfloat delta_y) {
          center.xpos += delta_x;
          center.ypos += delta_y;
       }
       void set(shared_ptr<shape> ptr, vertex cen, rgbcolor col) {
             pshape = ptr; center = cen; color = col;}
+      void set_shape (shared_ptr<shape> ptr) { pshape = ptr; }
+      void set_color (const rgbcolor& color_) { color = color_; }
       void set_pos(GLfloat delta_x, GLfloat delta_y) { 
          center.xpos = delta_x;
          center.ypos = delta_y;
       }
-      vertex get_pos () {return center;}
+      vertex get_pos () const {return center;}
+};
+
+//
+// A group is the run of objects [first,last) drawn between a group
+// and its endgroup, including any nested groups.  Moving a group
+// changes only its offset.  Its bounds, in its own coordinates, are
+// cached until one of its members moves, and let drawing and picking
+// skip the whole group when it is out of the way.
+//
+
+struct group {
+   string name;
+   size_t parent;
+   size_t first;
+   size_t last;
+   vertex offset {0, 0};
+   bbox bounds {};
+   bool dirty {true};
 };
 
 class mouse {
@@ -51,16 +99,25 @@ class mouse {
 
 class window {
       friend class mouse;
+      friend class input_log; // Replays the input callbacks.
    private:
       static int width;         // in pixels
       static int height;        // in pixels
       static GLfloat move_by;
+      static vertex origin;     // Of the view, moved by panning.
       static GLfloat thickness;
       static rgbcolor border_color;
       static vector<object> objects;
+      static vector<group> groups;
+      static vector<size_t> open_groups; // Not yet ended.
       static bool selected;
       static size_t selected_obj;
+      static size_t selected_group; // Moved instead, unless no_group.
+      static render_queue queue; // Leaves out queue_moving.
+      static pair<size_t,size_t> queue_moving; // Drawn on their own.
       static mouse mus;
+      using timer_fn = void (*) (int);
+      static vector<pair<unsigned,timer_fn>> timers;
    private:
       static void close();
       static void entry (int mouse_entered);
@@ -71,9 +128,45 @@ class window {
       static void motion (int x, int y);
       static void passivemotion (int x, int y);
       static void mousefn (int button, int state, int x, int y);
+      static void move_selected (GLfloat delta_x, GLfloat delta_y);
+      static void set_projection();
+      static void pan (GLfloat delta_x, GLfloat delta_y);
+      static void mark_dirty (size_t group);
+      static const bbox& group_bounds (size_t group);
+      static vertex group_offset (size_t group);
+      static vector<vertex> group_offsets();
+      static void visit (const bbox& area, const vector<vertex>& offsets,
+                         const function<void (size_t)>& func);
+      static size_t pick (int x, int y);
+      static pair<size_t,size_t> moving_range();
    public:
-      static void push_back (const object& obj) {
-                  objects.push_back (obj); }
+      static void push_back (object obj) {
+                  obj.set_group (open_groups.empty() ? no_group
+                                 : open_groups.back());
+                  objects.push_back (obj);
+                  queue.invalidate(); }
+      static void invalidate() { queue.invalidate(); }
+      static void begin_group (const string& name);
+      static void end_group();
+      static size_t close_groups();
+      static size_t group_count() { return groups.size(); }
+      static vertex world_offset (size_t index) {
+                  return group_offset (objects.at (index).get_group()); }
+      static void prepare();
+      using tile_list = vector<vector<render_queue::item>>;
+      static tile_list tiles (const bbox& area, GLfloat tile_size,
+                              size_t columns, size_t rows);
+      static void draw_area (const vector<render_queue::item>& tile,
+                             const bbox& area);
+      static void clear();
+      static size_t size() { return objects.size(); }
+      static object& at (size_t index) { return objects.at (index); }
+      static void splice (size_t first, size_t last,
+                          vector<object>&& replacement);
+      static void update_object (size_t index, const vertex& center,
+                                 const rgbcolor& color);
+      static void add_timer (unsigned msecs, timer_fn func) {
+                  timers.push_back ({msecs, func}); }
       static void set_move (GLfloat move_) { move_by = move_;}
       static void set_thick (GLfloat thickness_) 
             { thickness = thickness_;}
@@ -81,6 +174,8 @@ class window {
             {border_color = border_color_;} 
       static void setwidth (int width_) { width = width_; }
       static void setheight (int height_) { height = height_; }
+      static int get_width() { return width; }
+      static int get_height() { return height; }
       static GLfloat get_thick () { return thickness;}
       static rgbcolor get_border () {return border_color;}
       static bool is_selected() {return selected;}
@@ -0,0 +1,12 @@
+# $Id: grid.gd,v 1.1 2026-10-19 12:00:00-07 - - $
+# Grids and nested repeats: two interleaved grids of squares, and
+# three rising rows of circles.
+define sq square 40
+define dot circle 15
+drawgrid white sq 40 40 8 4 40 80
+drawgrid white sq 20 80 8 4 40 80
+repeat 3 0 120 {
+repeat 6 60 20 {
+draw red dot 400 40
+}
+}
@@ -0,0 +1,20 @@
+# $Id: groups.gd,v 1.1 2026-10-19 12:00:00-07 - - $
+# Nested groups.  Select an object, press g to select its group,
+# g again for the enclosing group, and move it with hjkl.
+define x64 ellipse 640 480
+define x32 ellipse 320 240
+define x16 ellipse 160 120
+define sq square 40
+group target
+draw red x64 320 240
+group bullseye
+draw green x32 320 240
+draw blue x16 320 240
+endgroup
+endgroup
+group markers
+draw yellow sq 100 100
+draw yellow sq 540 100
+draw yellow sq 100 380
+draw yellow sq 540 380
+endgroup
@@ -0,0 +1,190 @@
+// $Id: hud.cpp,v 1.1 2026-10-19 12:00:00-07 - - $
+
+// Must precede the first GL header to declare glWindowPos2i.
+#define GL_GLEXT_PROTOTYPES
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <unistd.h>
+using namespace std;
+
+#include <GL/freeglut.h>
+
+#include "debug.h"
+#include "hud.h"
+#include "interp.h"
+#include "rgbcolor.h"
+#include "util.h"
+
+bool hud::shown {false};
+size_t hud::vertices {0};
+size_t hud::draw_calls {0};
+hud::clock::time_point hud::frame_start;
+array<float,hud::history> hud::frame_msecs;
+size_t hud::frames {0};
+size_t hud::tick_frames {0};
+hud::clock::time_point hud::tick_time;
+size_t hud::last_drawn {0};
+size_t hud::last_culled {0};
+size_t hud::last_vertices {0};
+size_t hud::last_draw_calls {0};
+vector<string> hud::lines;
+array<size_t,hud::latency_buckets + 1> hud::latency_counts;
+size_t hud::latency_samples {0};
+float hud::latency_max {0};
+vector<hud::clock::time_point> hud::pending;
+bool hud::finish {false};
+
+static const unsigned refresh_msecs = 500;
+static bool ticking {false}; // A refresh timer is pending.
+
+void hud::begin_frame() {
+   frame_start = clock::now();
+   vertices = 0;
+   draw_calls = 0;
+}
+
+void hud::end_frame (size_t drawn, size_t culled) {
+   chrono::duration<float,milli> elapsed = clock::now() - frame_start;
+   frame_msecs[frames % history] = elapsed.count();
+   ++frames;
+   last_drawn = drawn;
+   last_culled = culled;
+   last_vertices = vertices;
+   last_draw_calls = draw_calls;
+}
+
+// The inputs handled since the last frame are all shown by this one.
+// The last bucket counts everything of 200 ms or more.
+void hud::presented() {
+   if (pending.empty()) return;
+   if (finish) glFinish();
+   clock::time_point now = clock::now();
+   for (const clock::time_point& stamp: pending) {
+      chrono::duration<float,milli> latency = now - stamp;
+      size_t bucket = latency.count() * 10;
+      ++latency_counts[min (bucket, latency_buckets)];
+      latency_max = max (latency_max, latency.count());
+      ++latency_samples;
+   }
+   pending.clear();
+}
+
+// Upper edge of the bucket holding the percentile, in milliseconds.
+float hud::latency_percentile (size_t pct) {
+   if (latency_samples == 0) return 0;
+   size_t rank = (latency_samples * pct + 99) / 100;
+   size_t seen = 0;
+   for (size_t bucket = 0; bucket < latency_buckets; ++bucket) {
+      seen += latency_counts[bucket];
+      if (seen >= rank) return min ((bucket + 1) / 10.0f, latency_max);
+   }
+   return latency_max;
+}
+
+void hud::report_latency() {
+   cerr << sys_info::execname() << ": input latency ms, "
+        << latency_samples << " inputs" << fixed << setprecision (1)
+        << ": p50 " << latency_percentile (50)
+        << ", p99 " << latency_percentile (99)
+        << ", max " << latency_max << endl;
+}
+
+void hud::request_latency (bool finish_) {
+   finish = finish_;
+   atexit (report_latency);
+}
+
+// Resident set size in bytes, or 0 if it cannot be read.
+static size_t resident_bytes() {
+   ifstream statm ("/proc/self/statm");
+   size_t total = 0;
+   size_t resident = 0;
+   if (not (statm >> total >> resident)) return 0;
+   return resident * sysconf (_SC_PAGESIZE);
+}
+
+void hud::refresh() {
+   clock::time_point now = clock::now();
+   chrono::duration<double> elapsed = now - tick_time;
+   double fps = elapsed.count() > 0
+              ? (frames - tick_frames) / elapsed.count() : 0;
+   tick_time = now;
+   tick_frames = frames;
+
+   vector<float> times (frame_msecs.begin(),
+                        frame_msecs.begin() + min (frames, history));
+   sort (times.begin(), times.end());
+   auto percentile = [&times] (size_t pct) {
+      return times.empty() ? 0.0f
+           : times[min (times.size() - 1, times.size() * pct / 100)];
+   };
+
+   lines.clear();
+   ostringstream line;
+   line << fixed << setprecision (1) << fps << " fps";
+   lines.push_back (line.str());
+   line.str ("");
+   line << "frame ms p50 " << setprecision (2) << percentile (50)
+        << "  p95 " << percentile (95) << "  p99 " << percentile (99);
+   lines.push_back (line.str());
+   line.str ("");
+   line << last_drawn << " drawn, " << last_culled << " culled";
+   lines.push_back (line.str());
+   line.str ("");
+   line << last_vertices << " vertices, " << last_draw_calls
+        << " draw calls";
+   lines.push_back (line.str());
+   line.str ("");
+   line << "input ms p50 " << setprecision (1)
+        << latency_percentile (50) << "  p99 "
+        << latency_percentile (99) << "  max " << latency_max;
+   lines.push_back (line.str());
+   line.str ("");
+   line << interpreter::shape_count() << " shapes, "
+        << resident_bytes() / 1024 << " KiB resident";
+   lines.push_back (line.str());
+   DEBUGF ('h', lines);
+}
+
+// Keep the overlay current even when nothing else redraws.
+void hud::tick (int) {
+   if (not shown) {
+      ticking = false;
+      return;
+   }
+   refresh();
+   glutPostRedisplay();
+   glutTimerFunc (refresh_msecs, tick, 0);
+}
+
+void hud::toggle() {
+   shown = not shown;
+   if (not shown) return;
+   tick_time = clock::now();
+   tick_frames = frames;
+   refresh();
+   if (not ticking) {
+      ticking = true;
+      glutTimerFunc (refresh_msecs, tick, 0);
+   }
+}
+
+// Top left, below the edge of the window.
+void hud::draw (int height) {
+   static rgbcolor color ("yellow");
+   if (not shown) return;
+   void* font = GLUT_BITMAP_HELVETICA_12;
+   glColor3ubv (color.ubvec);
+   int ypos = height - 18;
+   for (const string& text: lines) {
+      glWindowPos2i (10, ypos);
+      glutBitmapString (font,
+                        reinterpret_cast<const GLubyte*> (text.c_str()));
+      ypos -= 16;
+   }
+}
+
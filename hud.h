@@ -0,0 +1,69 @@
+// $Id: hud.h,v 1.1 2026-10-19 12:00:00-07 - - $
+
+//
+// hud -
+//    Optional overlay of performance counters, toggled with the f
+//    key: frames per second, frame time percentiles, objects drawn
+//    and culled, vertices and draw calls submitted, shapes defined,
+//    and resident memory.  Counting is a few increments per batch,
+//    done whether or not the overlay is shown.  The text is rebuilt
+//    twice a second while it is shown, not every frame.
+//
+//    Input latency is the time from an input callback to the swap
+//    of the first frame drawn after it, or, with glFinish requested,
+//    to when that swap has completed.  Each input is one sample in
+//    a histogram of 0.1 ms buckets, shown live in the overlay and,
+//    if requested, printed at exit.
+//
+
+#ifndef __HUD_H__
+#define __HUD_H__
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+using namespace std;
+
+class hud {
+   private:
+      using clock = chrono::steady_clock;
+      static constexpr size_t history = 128; // Frame times kept.
+      static bool shown;
+      static size_t vertices;      // In the current frame.
+      static size_t draw_calls;    // In the current frame.
+      static clock::time_point frame_start;
+      static array<float,history> frame_msecs;
+      static size_t frames;        // Since the program started.
+      static size_t tick_frames;   // At the last refresh.
+      static clock::time_point tick_time;
+      static size_t last_drawn, last_culled;
+      static size_t last_vertices, last_draw_calls;
+      static vector<string> lines;
+      static constexpr size_t latency_buckets = 2000; // 0.1 ms each.
+      static array<size_t,latency_buckets + 1> latency_counts;
+      static size_t latency_samples;
+      static float latency_max;   // In milliseconds.
+      static vector<clock::time_point> pending; // Inputs not shown.
+      static bool finish;         // glFinish after the swap.
+      static float latency_percentile (size_t pct);
+      static void report_latency();
+      static void refresh();
+      static void tick (int);
+   public:
+      hud() = delete;
+      static void count (size_t vertices_) {
+                  vertices += vertices_; ++draw_calls; }
+      static void begin_frame();
+      static void end_frame (size_t drawn, size_t culled);
+      static void input() { pending.push_back (clock::now()); }
+      static void presented(); // Just after glutSwapBuffers.
+      static void request_latency (bool finish); // Report at exit.
+      static void toggle();
+      static bool is_shown() { return shown; }
+      static void draw (int height);
+};
+
+#endif
+
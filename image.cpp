@@ -0,0 +1,141 @@
+// $Id: image.cpp,v 1.1 2026-10-19 12:00:00-07 - - $
+
+// Must precede the first GL header to declare the GL 3.0 functions.
+#define GL_GLEXT_PROTOTYPES
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+#include <vector>
+using namespace std;
+
+#include <GL/freeglut.h>
+
+#include "debug.h"
+#include "graphics.h"
+#include "image.h"
+#include "shader.h"
+#include "util.h"
+
+static const GLsizei tile_size = 1024; // Pixels on a side, at most.
+
+// Write all of a buffer at an offset, retrying short writes.
+static bool write_at (int fd, const GLubyte* data, size_t size,
+                      off_t offset) {
+   while (size > 0) {
+      ssize_t written = pwrite (fd, data, size, offset);
+      if (written < 0) {
+         if (errno == EINTR) continue;
+         return false;
+      }
+      data += written;
+      size -= written;
+      offset += written;
+   }
+   return true;
+}
+
+// A hidden window, for its GL context, and a framebuffer of one tile.
+static GLuint make_framebuffer() {
+   static int argc = 0;
+   glutInit (&argc, nullptr);
+   glutInitDisplayMode (GLUT_RGBA);
+   glutInitWindowSize (1, 1);
+   glutCreateWindow (sys_info::execname().c_str());
+   glutHideWindow();
+   ellipse_shader::init();
+   GLint major = 0;
+   glGetIntegerv (GL_MAJOR_VERSION, &major);
+   if (major < 3) return 0;
+   GLuint texture = 0;
+   glGenTextures (1, &texture);
+   glBindTexture (GL_TEXTURE_2D, texture);
+   glTexImage2D (GL_TEXTURE_2D, 0, GL_RGB8, tile_size, tile_size, 0,
+                 GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+   glBindTexture (GL_TEXTURE_2D, 0);
+   GLuint framebuffer = 0;
+   glGenFramebuffers (1, &framebuffer);
+   glBindFramebuffer (GL_FRAMEBUFFER, framebuffer);
+   glFramebufferTexture2D (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                           GL_TEXTURE_2D, texture, 0);
+   if (glCheckFramebufferStatus (GL_FRAMEBUFFER)
+       != GL_FRAMEBUFFER_COMPLETE) return 0;
+   return framebuffer;
+}
+
+int export_image (const string& filename) {
+   int width = window::get_width();
+   int height = window::get_height();
+   if (width <= 0 or height <= 0) {
+      complain() << filename << ": bad image size " << width << "x"
+                 << height << endl;
+      return EXIT_FAILURE;
+   }
+   if (make_framebuffer() == 0) {
+      complain() << filename << ": no framebuffer objects" << endl;
+      return EXIT_FAILURE;
+   }
+   int fd = open (filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+   if (fd < 0) {
+      syscall_error (filename);
+      return EXIT_FAILURE;
+   }
+
+   // PPM rows run from the top, GL rows from the bottom.
+   ostringstream header;
+   header << "P6\n" << width << " " << height << "\n255\n";
+   const string& head = header.str();
+   const off_t row_bytes = off_t (width) * 3;
+   bool ok = write_at (fd, reinterpret_cast<const GLubyte*>
+                           (head.data()), head.size(), 0)
+         and ftruncate (fd, head.size() + row_bytes * height) == 0;
+
+   window::prepare();
+   size_t tile_columns = (width + tile_size - 1) / tile_size;
+   size_t tile_rows = (height + tile_size - 1) / tile_size;
+   window::tile_list tiles = window::tiles (
+         {{0, 0}, {GLfloat (width), GLfloat (height)}}, tile_size,
+         tile_columns, tile_rows);
+   glClearColor (0.25, 0.25, 0.25, 1.0);
+   glPixelStorei (GL_PACK_ALIGNMENT, 1);
+   vector<GLubyte> pixels (tile_size * tile_size * 3);
+   for (int ylow = 0; ok and ylow < height; ylow += tile_size) {
+      GLsizei rows = min (tile_size, height - ylow);
+      for (int xlow = 0; ok and xlow < width; xlow += tile_size) {
+         GLsizei columns = min (tile_size, width - xlow);
+         glViewport (0, 0, columns, rows);
+         glMatrixMode (GL_PROJECTION);
+         glLoadIdentity();
+         gluOrtho2D (xlow, xlow + columns, ylow, ylow + rows);
+         glMatrixMode (GL_MODELVIEW);
+         text::set_window_origin ({GLfloat (xlow), GLfloat (ylow)});
+         glClear (GL_COLOR_BUFFER_BIT);
+         vector<render_queue::item>& tile
+               = tiles[ylow / tile_size * tile_columns
+                       + xlow / tile_size];
+         window::draw_area (tile, {{GLfloat (xlow), GLfloat (ylow)},
+                                   {GLfloat (xlow + columns),
+                                    GLfloat (ylow + rows)}});
+         tile = {};
+         glReadPixels (0, 0, columns, rows, GL_RGB, GL_UNSIGNED_BYTE,
+                       pixels.data());
+         for (GLsizei row = 0; ok and row < rows; ++row) {
+            off_t line = height - 1 - (ylow + row);
+            ok = write_at (fd, &pixels[row * columns * 3], columns * 3,
+                           head.size() + line * row_bytes + xlow * 3);
+         }
+         DEBUGF ('x', "tile " << xlow << "," << ylow << " "
+                 << columns << "x" << rows);
+      }
+   }
+   if (not ok) syscall_error (filename);
+   if (close (fd) < 0 and ok) {
+      syscall_error (filename);
+      ok = false;
+   }
+   return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
@@ -0,0 +1,23 @@
+// $Id: image.h,v 1.1 2026-10-19 12:00:00-07 - - $
+
+//
+// export_image -
+//    Render the scene at the size given by -w and -h, which may be
+//    far larger than any framebuffer, into a binary PPM file.  The
+//    image is drawn one tile at a time into an offscreen framebuffer,
+//    each tile visiting only the objects that overlap it, and each
+//    tile's rows are written straight to their places in the file.
+//    Memory use is one tile, whatever the size of the image.
+//    Returns EXIT_SUCCESS or EXIT_FAILURE.
+//
+
+#ifndef __IMAGE_H__
+#define __IMAGE_H__
+
+#include <string>
+using namespace std;
+
+int export_image (const string& filename);
+
+#endif
+
@@ -0,0 +1,205 @@
+// $Id: input.cpp,v 1.1 2026-10-19 12:00:00-07 - - $
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+using namespace std;
+
+#include <GL/freeglut.h>
+
+#include "debug.h"
+#include "graphics.h"
+#include "input.h"
+#include "util.h"
+
+ofstream input_log::recording;
+input_log::clock::time_point input_log::start;
+bool input_log::started {false};
+vector<pair<long,input_log::event>> input_log::script;
+size_t input_log::next {0};
+bool input_log::fast {false};
+int input_log::replay_modifiers {0};
+vector<double> input_log::handling[KINDS];
+vector<double> input_log::framing[KINDS];
+input_log::clock::time_point input_log::dispatched;
+input_log::kind input_log::awaiting {KINDS};
+
+static const string kind_names[] {
+   "key", "special", "mouse", "motion", "passive",
+};
+
+bool input_log::record (const string& filename) {
+   recording.open (filename);
+   if (recording.fail()) {
+      syscall_error (filename);
+      return false;
+   }
+   recording << "# " << sys_info::execname() << " input log, "
+             << window::get_width() << "x" << window::get_height()
+             << "\n";
+   return true;
+}
+
+// Called first thing by each window callback.  GLUT knows the
+// modifiers only during keyboard, special and mouse callbacks.
+void input_log::note (kind type, int code, int state,
+                      int xpos, int ypos) {
+   if (not recording.is_open()) return;
+   clock::time_point now = clock::now();
+   if (not started) {
+      start = now;
+      started = true;
+   }
+   long msecs = chrono::duration_cast<chrono::milliseconds>
+                (now - start).count();
+   int modifiers = type == KEY or type == SPECIAL or type == MOUSE
+                 ? glutGetModifiers() : 0;
+   recording << msecs << " " << kind_names[type] << " " << code << " "
+             << state << " " << xpos << " " << ypos << " " << modifiers
+             << "\n";
+}
+
+int input_log::modifiers() {
+   return script.empty() ? glutGetModifiers() : replay_modifiers;
+}
+
+bool input_log::replay (const string& filename, bool fast_) {
+   ifstream infile (filename);
+   if (infile.fail()) {
+      syscall_error (filename);
+      return false;
+   }
+   fast = fast_;
+   string line;
+   for (int linenr = 1; getline (infile, line); ++linenr) {
+      if (line.empty() or line[0] == '#') continue;
+      istringstream words (line);
+      long msecs;
+      string name;
+      event evt;
+      words >> msecs >> name >> evt.code >> evt.state >> evt.xpos
+            >> evt.ypos >> evt.modifiers;
+      auto found = find (begin (kind_names), end (kind_names), name);
+      if (words.fail() or found == end (kind_names)) {
+         complain() << filename << ":" << linenr << ": bad event"
+                    << endl;
+         return false;
+      }
+      evt.type = kind (found - begin (kind_names));
+      script.push_back ({msecs, evt});
+   }
+   if (script.empty()) {
+      complain() << filename << ": no events" << endl;
+      return false;
+   }
+   DEBUGF ('e', script.size() << " events from " << filename);
+   window::add_timer (0, step);
+   return true;
+}
+
+void input_log::dispatch (const event& evt) {
+   replay_modifiers = evt.modifiers;
+   switch (evt.type) {
+      case KEY:
+         window::keyboard (evt.code, evt.xpos, evt.ypos);
+         break;
+      case SPECIAL:
+         window::special (evt.code, evt.xpos, evt.ypos);
+         break;
+      case MOUSE:
+         window::mousefn (evt.code, evt.state, evt.xpos, evt.ypos);
+         break;
+      case MOTION:
+         window::motion (evt.xpos, evt.ypos);
+         break;
+      case PASSIVE: case KINDS:
+         window::passivemotion (evt.xpos, evt.ypos);
+         break;
+   }
+}
+
+// Closes the frame time of the event dispatched last, if this is
+// the first frame since.
+void input_log::presented() {
+   if (awaiting == KINDS) return;
+   chrono::duration<double,micro> took = clock::now() - dispatched;
+   framing[awaiting].push_back (took.count());
+   DEBUGF ('e', kind_names[awaiting] << " shown " << took.count()
+           << "us");
+   awaiting = KINDS;
+}
+
+// One event per timer, so the window is redisplayed between them.
+// At the recorded pace, the next timer is set for when its event
+// happened, counting from the first event.  A frame still awaited
+// when the next event comes was never drawn.
+void input_log::step (int) {
+   if (not started) {
+      start = clock::now();
+      started = true;
+   }
+   const event& evt = script[next].second;
+   dispatched = clock::now();
+   awaiting = evt.type;
+   dispatch (evt);
+   chrono::duration<double,micro> took = clock::now() - dispatched;
+   handling[evt.type].push_back (took.count());
+   DEBUGF ('e', next << ": " << kind_names[evt.type] << " "
+           << evt.code << " " << took.count() << "us");
+   if (++next == script.size()) {
+      glutTimerFunc (0, done, 0);
+      return;
+   }
+   long delay = 0;
+   if (not fast) {
+      long elapsed = chrono::duration_cast<chrono::milliseconds>
+                     (clock::now() - start).count();
+      delay = max (0L, script[next].first - script[0].first - elapsed);
+   }
+   glutTimerFunc (delay, step, 0);
+}
+
+// Set after the last event, so it runs once the frame drawn for
+// that event has been swapped.
+void input_log::done (int) {
+   report();
+   window::close();
+}
+
+// Mean, 99th percentile and maximum, or dashes if there are none.
+static void print_times (vector<double>& times) {
+   if (times.empty()) {
+      cout << setw (11) << "-" << setw (11) << "-" << setw (11) << "-";
+      return;
+   }
+   sort (times.begin(), times.end());
+   double sum = 0;
+   for (double time: times) sum += time;
+   cout << setw (11) << sum / times.size()
+        << setw (11) << times[(times.size() - 1) * 99 / 100]
+        << setw (11) << times.back();
+}
+
+void input_log::report() {
+   cout << "event      count    mean_us     p99_us     max_us"
+        << "   frames  frame_mean  frame_p99  frame_max\n"
+        << fixed << setprecision (1);
+   for (size_t type = 0; type < KINDS; ++type) {
+      if (handling[type].empty()) continue;
+      cout << left << setw (8) << kind_names[type] << right
+           << setw (8) << handling[type].size();
+      print_times (handling[type]);
+      cout << setw (9) << framing[type].size() << " ";
+      print_times (framing[type]);
+      cout << "\n";
+   }
+   for (size_t index = 0; index < window::size(); ++index) {
+      vertex offset = window::world_offset (index);
+      vertex pos = window::at (index).get_pos();
+      cout << "object " << index << " " << pos.xpos + offset.xpos
+           << " " << pos.ypos + offset.ypos << "\n";
+   }
+   cout.flush();
+}
+
@@ -0,0 +1,70 @@
+// $Id: input.h,v 1.1 2026-10-19 12:00:00-07 - - $
+
+//
+// input_log -
+//    Records the keyboard, special key, mouse button and mouse
+//    motion events given to the window, one line each with its time
+//    in milliseconds since the first, and replays such a log by
+//    calling the same window callbacks from a timer, either at the
+//    recorded pace or as fast as the window can take them.  A log
+//    line is
+//       msecs kind code state x y modifiers
+//    where kind is key, special, mouse, motion or passive; lines
+//    starting with # are comments, so logs may be written by hand.
+//    When the last event has been handled, replay prints the time
+//    taken by each kind of event and the final position of every
+//    object, then exits, so a log of an interaction is a benchmark.
+//    Two times are given for each kind: the callback alone, and from
+//    when the event was dispatched until the swap of the frame drawn
+//    after it.  An event that draws nothing has no frame time.
+//
+
+#ifndef __INPUT_H__
+#define __INPUT_H__
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+class input_log {
+   public:
+      enum kind {KEY, SPECIAL, MOUSE, MOTION, PASSIVE, KINDS};
+      struct event {
+         kind type;
+         int code;      // Key or button.
+         int state;     // Of a button.
+         int xpos;
+         int ypos;
+         int modifiers; // Shift, ctrl, alt.
+      };
+   private:
+      using clock = chrono::steady_clock;
+      static ofstream recording;
+      static clock::time_point start;
+      static bool started;
+      static vector<pair<long,event>> script; // Time and event.
+      static size_t next;
+      static bool fast;
+      static int replay_modifiers;
+      static vector<double> handling[KINDS]; // Microseconds.
+      static vector<double> framing[KINDS];  // Until the swap.
+      static clock::time_point dispatched;
+      static kind awaiting;                  // Its frame, or KINDS.
+      static void dispatch (const event&);
+      static void step (int);
+      static void done (int);
+      static void report();
+   public:
+      input_log() = delete;
+      static bool record (const string& filename);
+      static bool replay (const string& filename, bool fast);
+      static void note (kind type, int code, int state,
+                        int xpos, int ypos);
+      static int modifiers(); // Of the current event.
+      static void presented(); // Just after glutSwapBuffers.
+};
+
+#endif
+
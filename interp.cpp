@@ -3,6 +3,9 @@
 #include <iostream> //need?
 #include <fstream>
 
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
 #include <memory>
 #include <string>
 #include <vector>
@@ -10,17 +13,24 @@ using namespace std;
 
 #include <GL/freeglut.h>
 
+#include "api.h"
 #include "debug.h"
 #include "interp.h"
+#include "module.h"
 #include "shape.h"
 #include "util.h"
 
 unordered_map<string,interpreter::interpreterfn>
 interpreter::interp_map {
-   {"border" , &interpreter::do_border },
-   {"define" , &interpreter::do_define },
-   {"draw"   , &interpreter::do_draw   },
-   {"moveby" , &interpreter::do_moveby },
+   {"border"    , &interpreter::do_border    },
+   {"collisions", &interpreter::do_collisions},
+   {"define"    , &interpreter::do_define    },
+   {"draw"      , &interpreter::do_draw      },
+   {"drawgrid"  , &interpreter::do_drawgrid  },
+   {"endgroup"  , &interpreter::do_endgroup  },
+   {"group"     , &interpreter::do_group     },
+   {"include"   , &interpreter::do_include   },
+   {"moveby"    , &interpreter::do_moveby    },
 };
 
 unordered_map<string,interpreter::factoryfn>
@@ -37,18 +47,48 @@ interpreter::factory_map {
 };
 
 interpreter::shape_map interpreter::objmap;
+bool interpreter::strict {false};
+vertex interpreter::offset {0, 0};
+interpreter::place_fn interpreter::placer;
+vector<string> interpreter::sources;
 
 interpreter::~interpreter() {
+   if (not dump) return;
    for (const auto& itor: objmap) {
       cout << "objmap[" << itor.first << "] = "
-           << *itor.second << endl;
+           << *itor.second << '\n';
    }
 }
 
+void interpreter::clear() {
+   objmap.clear();
+}
+
+shape_ptr interpreter::find (const string& name) {
+   auto itor = objmap.find (name);
+   return itor == objmap.end() ? nullptr : itor->second;
+}
+
+void interpreter::undefine (const string& name) {
+   objmap.erase (name);
+}
+
 void interpreter::interpret (const parameters& params) {
    DEBUGF ('i', params);
    param begin = params.cbegin();
    string command = *begin;
+   if (depth > 0) {
+      // Inside a repeat, commands are saved until its }.
+      if (command == "repeat") ++depth;
+      if (command == "}") --depth;
+      if (depth > 0) repeat_body.push_back (params);
+                else end_repeat();
+      return;
+   }
+   if (command == "repeat") {
+      begin_repeat (++begin, params.cend());
+      return;
+   }
    auto itor = interp_map.find (command);
    if (itor == interp_map.end()) throw runtime_error ("syntax error");
    interpreterfn func = itor->second;
@@ -57,14 +97,20 @@ void interpreter::interpret (const parameters& params) {
 
 void interpreter::do_border (param begin, param end) {
    DEBUGF ('f', range (begin, end));
-   rgbcolor border_color {begin[0]};
+   if (end - begin != 2) throw runtime_error ("syntax error");
+   gdraw::set_border (rgbcolor {begin[0]},
+                      from_string<GLfloat> (begin[1]));
+}
 
-   window::set_border(border_color);
-   window::set_thick(from_string<GLfloat> (begin[1]));
+void interpreter::do_collisions (param begin, param end) {
+   DEBUGF ('f', range (begin, end));
+   if (end - begin != 0) throw runtime_error ("syntax error");
+   gdraw::track_collisions();
 }
 
 void interpreter::do_define (param begin, param end) {
    DEBUGF ('f', range (begin, end));
+   if (end - begin < 2) throw runtime_error ("syntax error");
    string name = *begin;
    objmap.emplace (name, make_shape (++begin, end));
 }
@@ -73,31 +119,165 @@ void interpreter::do_draw (param begin, param end) {
    DEBUGF ('f', range (begin, end));
    if (end - begin != 4) throw runtime_error ("syntax error");
    string name = begin[1];
-   shape_map::const_iterator itor = objmap.find (name);
-   if (itor == objmap.end()) {
+   if (objmap.find (name) == objmap.end() and not strict) {
+      cerr << name + ": no such shape" << endl;
+      return;
+   }
+
+   // add shape object to display window
+   object shape = placement (begin, end);
+   shape.move (offset.xpos, offset.ypos);
+
+   // set default border color and line thickness for select
+   default_border();
+   place (shape);
+}
+
+// Only the outermost repeat is read here; those inside it are read
+// again each time its body is interpreted.
+void interpreter::begin_repeat (param begin, param end) {
+   DEBUGF ('f', range (begin, end));
+   if (end - begin != 4 or begin[3] != "{") {
+      throw runtime_error ("syntax error");
+   }
+   long count = from_string<long> (begin[0]);
+   if (count < 0) throw runtime_error (begin[0] + ": negative count");
+   repeat_count = count;
+   repeat_step = {from_string<GLfloat> (begin[1]),
+                  from_string<GLfloat> (begin[2])};
+   depth = 1;
+}
+
+void interpreter::end_repeat() {
+   // Repeats in the body overwrite the members as they are read.
+   vector<parameters> body = move (repeat_body);
+   repeat_body.clear();
+   size_t count = repeat_count;
+   vertex step = repeat_step;
+   vertex start = offset;
+   for (size_t index = 0; index < count; ++index) {
+      offset = {start.xpos + index * step.xpos,
+                start.ypos + index * step.ypos};
+      try {
+         for (const parameters& params: body) interpret (params);
+      }catch (...) {
+         offset = start;
+         throw;
+      }
+   }
+   offset = start;
+}
+
+// The row of each object is looked up and converted once, not once
+// per object as a draw would.
+void interpreter::do_drawgrid (param begin, param end) {
+   DEBUGF ('f', range (begin, end));
+   if (end - begin != 8) throw runtime_error ("syntax error");
+   string name = begin[1];
+   if (objmap.find (name) == objmap.end() and not strict) {
       cerr << name + ": no such shape" << endl;
       return;
+   }
+   object shape = placement (begin, begin + 4);
+   long columns = from_string<long> (begin[4]);
+   long rows = from_string<long> (begin[5]);
+   if (columns < 0 or rows < 0) {
+      throw runtime_error ("negative grid size");
+   }
+   GLfloat delta_x = from_string<GLfloat> (begin[6]);
+   GLfloat delta_y = from_string<GLfloat> (begin[7]);
+   vertex corner = shape.get_pos();
+   corner = {corner.xpos + offset.xpos, corner.ypos + offset.ypos};
+   gdraw::draw_grid (find (name), shape.get_color(), corner, columns,
+                     rows, {delta_x, delta_y}, place);
+   default_border();
+}
+
+// Make the object described by the operands of a draw command.
+object interpreter::placement (param begin, param end) {
+   if (end - begin != 4) throw runtime_error ("syntax error");
+   string name = begin[1];
+   shape_map::const_iterator itor = objmap.find (name);
+   if (itor == objmap.end()) {
       throw runtime_error (name + ": no such shape");
    }
    rgbcolor color {begin[0]};
-   rgbcolor border_color {"red"};
    vertex where {from_string<GLfloat> (begin[2]),
                  from_string<GLfloat> (begin[3])};
-
-   // add shape object to display window
-   object shape; 
+   object shape;
    shape.set(itor->second, where, color);
+   return shape;
+}
 
-   // set default border color and line thickness for select
-   window::set_border(border_color);
-   window::set_thick(4.0);
-   window::push_back(shape);
+void interpreter::default_border() {
+   gdraw::set_border (rgbcolor {"red"}, 4.0);
+}
+
+void interpreter::do_group (param begin, param end) {
+   DEBUGF ('f', range (begin, end));
+   if (end - begin != 1) throw runtime_error ("syntax error");
+   gdraw::begin_group (begin[0]);
+}
+
+void interpreter::do_endgroup (param begin, param end) {
+   DEBUGF ('f', range (begin, end));
+   if (end - begin != 0) throw runtime_error ("syntax error");
+   gdraw::end_group();
 }
 
 void interpreter::do_moveby (param begin, param end) {
    DEBUGF ('f', range (begin, end));
+   if (end - begin != 1) throw runtime_error ("syntax error");
+   gdraw::set_move (from_string<GLfloat> (begin[0]));
+}
+
+void interpreter::do_include (param begin, param end) {
+   DEBUGF ('f', range (begin, end));
+   if (end - begin != 1) throw runtime_error ("syntax error");
+   include (resolve (begin[0], sources.empty() ? "" : sources.back()));
+}
+
+// The first definition of a name counts, as in do_define.
+void interpreter::include (const string& path) {
+   auto cycle = std::find (sources.begin(), sources.end(), path);
+   if (cycle != sources.end()) {
+      string chain;
+      for (; cycle != sources.end(); ++cycle) chain += *cycle + " -> ";
+      throw runtime_error ("include cycle: " + chain + path);
+   }
+   module_ptr included = module_cache::load (path);
+   sources.push_back (path);
+   try {
+      for (const module::entry& entry: included->entries) {
+         if (entry.pshape != nullptr) {
+            objmap.emplace (entry.name, entry.pshape);
+         }else {
+            include (resolve (entry.type, path));
+         }
+      }
+   }catch (...) {
+      sources.pop_back();
+      throw;
+   }
+   sources.pop_back();
+}
 
-   window::set_move(from_string<GLfloat> (begin[0]));
+// Relative to the directory of the file it is read from, and
+// canonical if it exists, so that cycles are found however the
+// files name each other.
+string interpreter::resolve (const string& path, const string& from) {
+   string result = path;
+   size_t slash = from.rfind ('/');
+   if (path[0] != '/' and slash != string::npos) {
+      result = from.substr (0, slash + 1) + path;
+   }
+   char real[PATH_MAX];
+   if (realpath (result.c_str(), real) != nullptr) result = real;
+   return result;
+}
+
+void interpreter::push_source (const string& filename) {
+   sources.push_back (filename == "-" ? "" : resolve (filename, ""));
 }
 
 shape_ptr interpreter::make_shape (param begin, param end) {
@@ -111,102 +291,130 @@ shape_ptr interpreter::make_shape (param begin, param end) {
    return func (begin, end);
 }
 
+// The words after the font name, each separated by one space.
 shape_ptr interpreter::make_text (param begin, param end) {
    DEBUGF ('f', range (begin, end));
-   void* glut_bitmap_font = nullptr;
-   string s = "";
-   int count = 0;
-
-   for(auto i = begin; i != end; ++i) ++count;
-
-   // case checking 
-   if (begin[0] == "Fixed-8x13")
-      glut_bitmap_font = GLUT_BITMAP_8_BY_13;
-   else if (begin[0] == "Fixed-9x15")
-      glut_bitmap_font = GLUT_BITMAP_9_BY_15;
-   else if (begin[0] == "Helvetica-10")
-      glut_bitmap_font = GLUT_BITMAP_HELVETICA_10;
-   else if (begin[0] == "Helvetica-12")
-      glut_bitmap_font = GLUT_BITMAP_HELVETICA_12;
-   else if (begin[0] == "Helvetica-18")
-      glut_bitmap_font = GLUT_BITMAP_HELVETICA_18;
-   else if (begin[0] == "Times-Roman-10")
-      glut_bitmap_font = GLUT_BITMAP_TIMES_ROMAN_10;
-   else if (begin[0] == "Times-Roman-24")
-      glut_bitmap_font = GLUT_BITMAP_TIMES_ROMAN_24;
- 
-   // store text data
-   count -= 1;
-   for(int i = 1; i != count; ++i) {
-      s.append(begin[i] + " ");
-   }
-   s.append(begin[count]); 
-
-   return make_shared<text> (glut_bitmap_font, s);
+   if (end - begin < 2) throw runtime_error ("syntax error");
+   string textdata = begin[1];
+   for (param word = begin + 2; word != end; ++word) {
+      textdata += " " + *word;
+   }
+   return gdraw::make_text (begin[0], textdata);
 }
 
 shape_ptr interpreter::make_ellipse (param begin, param end) {
    DEBUGF ('f', range (begin, end));
-
-   GLfloat w = from_string<GLfloat> (begin[0]);
-   GLfloat h = from_string<GLfloat> (begin[1]); 
-
-   return make_shared<ellipse> (w, h);
+   if (end - begin != 2) throw runtime_error ("syntax error");
+   return gdraw::make_ellipse (from_string<GLfloat> (begin[0]),
+                               from_string<GLfloat> (begin[1]));
 }
 
 shape_ptr interpreter::make_circle (param begin, param end) {
    DEBUGF ('f', range (begin, end));
-   return make_shared<circle> (from_string<GLfloat> (begin[0]));
+   if (end - begin != 1) throw runtime_error ("syntax error");
+   return gdraw::make_circle (from_string<GLfloat> (begin[0]));
 }
 
 shape_ptr interpreter::make_polygon (param begin, param end) {
    DEBUGF ('f', range (begin, end));
 
-  vertex_list v; 
-  vertex pair; 
-  int count = 0;
-
-  for(auto i = begin; i != end; ++i) ++count;
-
-  // get (x,y) coordinate for vertices of polygon
-  for(auto i = 0; i != count; i+=2) {
-     pair.xpos = from_string<GLfloat> (begin[i]);
-     pair.ypos = from_string<GLfloat> (begin[i+1]);
+   ptrdiff_t count = end - begin;
+   if (count < 6 or count % 2 != 0) {
+      throw runtime_error ("syntax error");
+   }
 
-     v.push_back(pair);
-  } 
+   // (x,y) coordinates of the vertices, each written once into a
+   // list of the right size, which the polygon then takes over
+   vertex_list v;
+   v.reserve (count / 2);
+   for (param coord = begin; coord != end; coord += 2) {
+      v.push_back ({from_string<GLfloat> (coord[0]),
+                    from_string<GLfloat> (coord[1])});
+   }
 
-   return make_shared<polygon> (v);
+   return gdraw::make_polygon (move (v));
 }
 
 shape_ptr interpreter::make_rectangle (param begin, param end) {
    DEBUGF ('f', range (begin, end));
-
-   GLfloat w = from_string<GLfloat> (begin[0]);
-   GLfloat h = from_string<GLfloat> (begin[1]);
-
-   return make_shared<rectangle> (w, h);
+   if (end - begin != 2) throw runtime_error ("syntax error");
+   return gdraw::make_rectangle (from_string<GLfloat> (begin[0]),
+                                 from_string<GLfloat> (begin[1]));
 }
 
 shape_ptr interpreter::make_square (param begin, param end) {
    DEBUGF ('f', range (begin, end));
-   return make_shared<square> (from_string<GLfloat> (begin[0]));
+   if (end - begin != 1) throw runtime_error ("syntax error");
+   return gdraw::make_square (from_string<GLfloat> (begin[0]));
 }
 
 shape_ptr interpreter::make_diamond (param begin, param end) {
    DEBUGF ('f', range (begin, end));
-
-   GLfloat w = from_string<GLfloat> (begin[0]);
-   GLfloat h = from_string<GLfloat> (begin[1]);
-
-   return make_shared<diamond> (w, h);
+   if (end - begin != 2) throw runtime_error ("syntax error");
+   return gdraw::make_diamond (from_string<GLfloat> (begin[0]),
+                               from_string<GLfloat> (begin[1]));
 }
 
 shape_ptr interpreter::make_equilateral (param begin, param end) {
    DEBUGF ('f', range (begin, end));
+   if (end - begin != 1) throw runtime_error ("syntax error");
+   return gdraw::make_equilateral (from_string<GLfloat> (begin[0]));
+}
 
-   GLfloat w = from_string<GLfloat> (begin[0]);
+//
+// Parse a file.  Read lines from input file, parse each line,
+// and interpret the command.  Unless dump is false, the shapes
+// defined are printed when parsing is done.
+//
+
+bool read_command (istream& infile, interpreter::parameters& words) {
+   words.clear();
+   string line;
+   getline (infile, line);
+   if (infile.eof()) return false;
+   if (line.size() == 0) return true;
+   for (;;) {
+      DEBUGF ('m', line);
+      int last = line.size() - 1;
+      if (line[last] != '\\') break;
+      line[last] = ' ';
+      string contin;
+      getline (infile, contin);
+      if (infile.eof()) break;
+      line += contin;
+   }
+   words = split (line, " \t");
+   if (words.size() > 0 and words.front()[0] == '#') words.clear();
+   return true;
+}
 
-   return make_shared<equilateral> (w);
+void parsefile (const string& infilename, istream& infile, bool dump) {
+   interpreter interp (dump);
+   interpreter::parameters words;
+   interpreter::push_source (infilename);
+   for (int linenr = 1; read_command (infile, words); ++linenr) {
+      if (words.size() == 0) continue;
+      try {
+         DEBUGF ('m', words);
+         interp.interpret (words);
+      }catch (runtime_error& error) {
+         complain() << infilename << ":" << linenr << ": "
+                    << error.what() << endl;
+      }catch (invalid_argument& error) {
+         // Thrown by rgbcolor for an unknown color name.
+         complain() << infilename << ":" << linenr << ": "
+                    << error.what() << endl;
+      }
+   }
+   if (interp.in_repeat()) {
+      complain() << infilename << ": missing }" << endl;
+   }
+   if (window::close_groups() > 0) {
+      complain() << infilename << ": missing endgroup" << endl;
+   }
+   interpreter::pop_source();
+   DEBUGF ('m', infilename << " EOF");
 }
 
+
+
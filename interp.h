@@ -3,6 +3,7 @@
 #ifndef __INTERP_H__
 #define __INTERP_H__
 
+#include <functional>
 #include <iostream>
 #include <unordered_map>
 #include <vector>
@@ -12,6 +13,27 @@ using namespace std;
 #include "graphics.h"
 #include "shape.h"
 
+//
+// interpreter -
+//    Interprets one command at a time.  Besides one object per draw,
+//       drawgrid color name x0 y0 cols rows dx dy
+//    places cols by rows objects starting at (x0,y0), and
+//       repeat count dx dy {
+//       ...
+//       }
+//    interprets the commands up to the matching } count times,
+//    offsetting what they draw by (dx,dy) more each time.  Repeats
+//    may nest; their offsets add up.
+//       include path.gd
+//    defines the shapes defined in path.gd, which may hold only
+//    define and include lines, relative to the including file.
+//    Each file is parsed once, see module_cache, and including a
+//    file that is already being included is an error.
+//       collisions
+//    outlines overlapping objects and reports each pair as it
+//    begins to overlap, see collisions.
+//
+
 class interpreter {
    public:
       using shape_map = unordered_map<string,shape_ptr>;
@@ -19,22 +41,56 @@ class interpreter {
       using param = parameters::const_iterator;
       using range = pair<param,param>;
       void interpret (const parameters&);
-      interpreter() {}
+      interpreter (bool dump_ = true): dump (dump_) {}
       ~interpreter();
       interpreter (const interpreter&) = delete;
       interpreter& operator= (const interpreter&) = delete;
 
+      static void clear();
+      static void set_strict (bool strict_) { strict = strict_; }
+      static shape_ptr find (const string& name);
+      static void undefine (const string& name);
+      static object placement (param begin, param end);
+      static void default_border();
+      static size_t shape_count() { return objmap.size(); }
+      using place_fn = function<void (const object&)>;
+      static void set_placer (place_fn placer_) { placer = placer_; }
+      bool in_repeat() const { return depth > 0; } // Missing }.
+      static string resolve (const string& path, const string& from);
+      static void push_source (const string& filename);
+      static void pop_source() { sources.pop_back(); }
+
    private:
+      bool dump; // Print objmap when destroyed.
+      size_t depth {0};         // Of the repeats being read.
+      size_t repeat_count {0};  // Of the outermost one.
+      vertex repeat_step {0, 0};
+      vector<parameters> repeat_body;
+      void begin_repeat (param begin, param end);
+      void end_repeat();
       using interpreterfn = void (*) (param, param);
       using factoryfn = shape_ptr (*) (param, param);
 
       static unordered_map<string,interpreterfn> interp_map;
       static unordered_map<string,factoryfn> factory_map;
       static shape_map objmap;
+      static bool strict; // Drawing an undefined shape is an error.
+      static vertex offset; // Of the repeats being interpreted.
+      static place_fn placer; // Instead of adding to the window.
+      static vector<string> sources; // Being read, outermost first.
+      static void include (const string& path);
+      static void place (const object& obj) {
+                  if (placer) placer (obj);
+                         else window::push_back (obj); }
 
       static void do_border (param begin, param end);
+      static void do_collisions (param begin, param end);
       static void do_define (param begin, param end);
       static void do_draw (param begin, param end);
+      static void do_drawgrid (param begin, param end);
+      static void do_endgroup (param begin, param end);
+      static void do_group (param begin, param end);
+      static void do_include (param begin, param end);
       static void do_moveby (param begin, param end);
 
       static shape_ptr make_shape (param begin, param end);
@@ -50,5 +106,23 @@ class interpreter {
       static shape_ptr make_line (param begin, param end);
 };
 
+//
+// read_command -
+//    Read one command, joining lines that end in a backslash, and
+//    split it into words.  Blank lines and comments leave words
+//    empty.  Returns false at end of file.
+//
+
+bool read_command (istream& infile, interpreter::parameters& words);
+
+//
+// parsefile -
+//    Read and interpret every line of a .gd file, complaining
+//    about errors with the file name and line number.
+//
+
+void parsefile (const string& infilename, istream& infile,
+                bool dump = true);
+
 #endif
 
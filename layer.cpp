@@ -0,0 +1,91 @@
+// $Id: layer.cpp,v 1.1 2026-10-19 12:00:00-07 - - $
+
+// Must precede the first GL header to declare the GL 3.0 functions.
+#define GL_GLEXT_PROTOTYPES
+
+#include <iostream>
+using namespace std;
+
+#include <GL/freeglut.h>
+
+#include "debug.h"
+#include "hud.h"
+#include "layer.h"
+#include "util.h"
+
+bool layer_cache::requested {false};
+bool layer_cache::supported {false};
+GLuint layer_cache::framebuffer {0};
+GLuint layer_cache::texture {0};
+int layer_cache::width {0};
+int layer_cache::height {0};
+bool layer_cache::valid {false};
+
+void layer_cache::init() {
+   if (not requested) return;
+   GLint major = 0;
+   glGetIntegerv (GL_MAJOR_VERSION, &major);
+   DEBUGF ('y', "GL major version " << major);
+   if (major < 3) {
+      cerr << sys_info::execname()
+           << ": no framebuffer objects, layer cache disabled" << endl;
+      return;
+   }
+   glGenFramebuffers (1, &framebuffer);
+   glGenTextures (1, &texture);
+   supported = true;
+}
+
+// The texture follows the window size, and is reallocated only when
+// that changes.
+void layer_cache::begin (int width_, int height_) {
+   glBindFramebuffer (GL_FRAMEBUFFER, framebuffer);
+   if (width_ != width or height_ != height) {
+      width = width_;
+      height = height_;
+      glBindTexture (GL_TEXTURE_2D, texture);
+      glTexImage2D (GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0,
+                    GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+      glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      glBindTexture (GL_TEXTURE_2D, 0);
+      glFramebufferTexture2D (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_TEXTURE_2D, texture, 0);
+      GLenum status = glCheckFramebufferStatus (GL_FRAMEBUFFER);
+      if (status != GL_FRAMEBUFFER_COMPLETE) {
+         cerr << sys_info::execname() << ": framebuffer incomplete ("
+              << status << "), layer cache disabled" << endl;
+         glBindFramebuffer (GL_FRAMEBUFFER, 0);
+         supported = false;
+         return;
+      }
+      DEBUGF ('y', "layer " << width << "x" << height);
+   }
+   glClear (GL_COLOR_BUFFER_BIT);
+}
+
+void layer_cache::end() {
+   glBindFramebuffer (GL_FRAMEBUFFER, 0);
+   valid = supported;
+}
+
+// One quad covering the view, texels to pixels one to one.
+void layer_cache::draw (GLfloat xpos, GLfloat ypos) {
+   glEnable (GL_TEXTURE_2D);
+   glBindTexture (GL_TEXTURE_2D, texture);
+   glTexEnvi (GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+   glBegin (GL_QUADS);
+   glTexCoord2f (0, 0);
+   glVertex2f (xpos, ypos);
+   glTexCoord2f (1, 0);
+   glVertex2f (xpos + width, ypos);
+   glTexCoord2f (1, 1);
+   glVertex2f (xpos + width, ypos + height);
+   glTexCoord2f (0, 1);
+   glVertex2f (xpos, ypos + height);
+   glEnd();
+   glBindTexture (GL_TEXTURE_2D, 0);
+   glDisable (GL_TEXTURE_2D);
+   hud::count (4);
+}
+
@@ -0,0 +1,42 @@
+// $Id: layer.h,v 1.1 2026-10-19 12:00:00-07 - - $
+
+//
+// layer_cache -
+//    Optional offscreen framebuffer holding everything except the
+//    objects that move with the keys, that is, the selected object
+//    or the selected group.  It is drawn once and then redrawn
+//    only when the scene, the viewport, or the selection changes,
+//    so a frame is one textured quad plus the moving objects and
+//    the overlays.  The moving objects are drawn over the layer,
+//    so they are always on top while selected.  Needs framebuffer
+//    objects; if there are none, every object is drawn every frame
+//    as before.
+//
+
+#ifndef __LAYER_H__
+#define __LAYER_H__
+
+#include <GL/freeglut.h>
+
+class layer_cache {
+   private:
+      static bool requested;
+      static bool supported;
+      static GLuint framebuffer;
+      static GLuint texture;
+      static int width;
+      static int height;
+      static bool valid;
+   public:
+      layer_cache() = delete;
+      static void request() { requested = true; }
+      static void init(); // After the GL context exists.
+      static bool enabled() { return supported; }
+      static bool is_valid() { return valid; }
+      static void begin (int width, int height); // Draw into layer.
+      static void end();                          // Back to window.
+      static void draw (GLfloat xpos, GLfloat ypos); // View origin.
+};
+
+#endif
+
@@ -1,71 +1,177 @@
 // $Id: main.cpp,v 1.2 2016-07-20 21:33:16-07 - - $
 
 #include <fstream>
+#include <getopt.h>
 #include <iostream>
 #include <unistd.h>
 #include <vector>
 using namespace std;
 
+#include "api.h"
+#include "capture.h"
+#include "check.h"
 #include "debug.h"
+#include "feed.h"
 #include "graphics.h"
+#include "hud.h"
+#include "input.h"
 #include "interp.h"
+#include "layer.h"
+#include "paged.h"
+#include "perf.h"
+#include "reload.h"
+#include "shader.h"
 #include "util.h"
 
 //
-// Parse a file.  Read lines from input file, parse each line,
-// and interpret the command.
+// Modes other than drawing, selected by long options.
 //
 
-void parsefile (const string& infilename, istream& infile) {
-   interpreter::shape_map shapemap;
-   interpreter interp;
-   for (int linenr = 1;; ++linenr) {
-      try {
-         string line;
-         getline (infile, line);
-         if (infile.eof()) break;
-         if (line.size() == 0) continue;
-         for (;;) {
-            DEBUGF ('m', line);
-            int last = line.size() - 1;
-            if (line[last] != '\\') break;
-            line[last] = ' ';
-            string contin;
-            getline (infile, contin);
-            if (infile.eof()) break;
-            line += contin;
-         }
-         interpreter::parameters words = split (line, " \t");
-         if (words.size() == 0 or words.front()[0] == '#') continue;
-         DEBUGF ('m', words);
-         interp.interpret (words);
-      }catch (runtime_error error) {
-         complain() << infilename << ":" << linenr << ": "
-                    << error.what() << endl;
-      }
+enum class run_mode {DRAW, CHECK, EXPORT, EXPORT_SVG, PACK,
+                     PERF_CHECK, PERF_RECORD};
+static run_mode mode = run_mode::DRAW;
+static string baseline = "perf-baseline.json";
+static string image_file; // For --export and --export-svg.
+static string page_file;  // For --pack and --paged.
+static string feed_name;  // For --feed.
+static string input_file; // For --record and --replay.
+enum class input_mode {LIVE, RECORD, REPLAY, REPLAY_FAST};
+static input_mode input = input_mode::LIVE;
+static int jobs = 0; // Worker processes for --check, 0 = per cpu.
+
+//
+// The number given to an option, which must not be negative.  A bad
+// one is reported and ends the program.
+//
+
+static long number_option (const string& option) {
+   long result = -1;
+   try {
+      result = from_string<long> (optarg);
+   }catch (exception&) {
    }
-   DEBUGF ('m', infilename << " EOF");
+   if (result < 0) {
+      complain() << option << " " << optarg << ": invalid number"
+                 << endl;
+      exit (EXIT_FAILURE);
+   }
+   return result;
 }
 
-
 //
 // Scan the option -@ and check for operands.
 //
 
 void scan_options (int argc, char** argv) {
+   enum {CAPTURE = 256, CHECK, COMPACT, EXPORT, EXPORT_SVG, FEED,
+         LATENCY, LAYER_CACHE, PACK, PAGE_BUDGET, PAGED, PERF_CHECK,
+         PERF_RECORD, RECORD, REPLAY, REPLAY_FAST, SHADER};
+   static const struct option long_options[] {
+      {"capture-every"   , required_argument, nullptr, CAPTURE    },
+      {"check"           , no_argument      , nullptr, CHECK      },
+      {"compact-vertices", no_argument      , nullptr, COMPACT    },
+      {"export"          , required_argument, nullptr, EXPORT     },
+      {"export-svg"      , required_argument, nullptr, EXPORT_SVG },
+      {"feed"            , required_argument, nullptr, FEED       },
+      {"latency"         , optional_argument, nullptr, LATENCY    },
+      {"layer-cache"     , no_argument      , nullptr, LAYER_CACHE},
+      {"pack"            , required_argument, nullptr, PACK       },
+      {"page-budget"     , required_argument, nullptr, PAGE_BUDGET},
+      {"paged"           , required_argument, nullptr, PAGED      },
+      {"perf-check"      , optional_argument, nullptr, PERF_CHECK },
+      {"perf-record"     , optional_argument, nullptr, PERF_RECORD},
+      {"record"          , required_argument, nullptr, RECORD     },
+      {"replay"          , required_argument, nullptr, REPLAY     },
+      {"replay-fast"     , required_argument, nullptr, REPLAY_FAST},
+      {"shader"          , no_argument      , nullptr, SHADER     },
+      {nullptr           , 0                , nullptr, 0          },
+   };
    opterr = 0;
    for (;;) {
-      int option = getopt (argc, argv, "@:w:h:");
+      int option = getopt_long (argc, argv, "@:j:T:w:h:",
+                                long_options, nullptr);
       if (option == EOF) break;
       switch (option) {
+         case CAPTURE:
+            frame_capture::set_every (
+                  number_option ("--capture-every"));
+            break;
+         case CHECK:
+            mode = run_mode::CHECK;
+            break;
+         case COMPACT:
+            polygon::set_compact (true);
+            break;
+         case EXPORT:
+            mode = run_mode::EXPORT;
+            image_file = optarg;
+            break;
+         case EXPORT_SVG:
+            mode = run_mode::EXPORT_SVG;
+            image_file = optarg;
+            break;
+         case 'T':
+            debugflags::setlogfile (optarg);
+            break;
+         case 'j':
+            jobs = number_option ("-j");
+            break;
+         case SHADER:
+            ellipse_shader::request();
+            break;
+         case FEED:
+            feed_name = optarg;
+            break;
+         case LATENCY:
+            // A bad value only loses the report, so it is not an error.
+            if (optarg != nullptr and optarg != string ("finish")) {
+               cerr << sys_info::execname() << ": --latency=" << optarg
+                    << ": only finish allowed, ignored" << endl;
+               break;
+            }
+            hud::request_latency (optarg != nullptr);
+            break;
+         case LAYER_CACHE:
+            layer_cache::request();
+            break;
+         case PACK:
+            mode = run_mode::PACK;
+            page_file = optarg;
+            break;
+         case PAGE_BUDGET:
+            paged_scene::set_budget (number_option ("--page-budget"));
+            break;
+         case PAGED:
+            page_file = optarg;
+            break;
+         case PERF_CHECK:
+            mode = run_mode::PERF_CHECK;
+            if (optarg != nullptr) baseline = optarg;
+            break;
+         case PERF_RECORD:
+            mode = run_mode::PERF_RECORD;
+            if (optarg != nullptr) baseline = optarg;
+            break;
+         case RECORD:
+            input = input_mode::RECORD;
+            input_file = optarg;
+            break;
+         case REPLAY:
+            input = input_mode::REPLAY;
+            input_file = optarg;
+            break;
+         case REPLAY_FAST:
+            input = input_mode::REPLAY_FAST;
+            input_file = optarg;
+            break;
          case '@':
             debugflags::setflags (optarg);
             break;
          case 'w':
-            window::setwidth (stoi (optarg));
+            window::setwidth (number_option ("-w"));
             break;
          case 'h':
-            window::setheight (stoi (optarg));
+            window::setheight (number_option ("-h"));
             break;
          default:
             complain() << "-" << char (optopt) << ": invalid option"
@@ -81,9 +187,33 @@ void scan_options (int argc, char** argv) {
 int main (int argc, char** argv) {
    sys_info::execname (argv[0]);
    scan_options (argc, argv);
+   switch (mode) {
+      case run_mode::PERF_CHECK: return perf_check (baseline);
+      case run_mode::PERF_RECORD: return perf_record (baseline);
+      case run_mode::CHECK: case run_mode::EXPORT:
+      case run_mode::EXPORT_SVG:
+      case run_mode::PACK: case run_mode::DRAW: break;
+   }
    vector<string> args (&argv[optind], &argv[argc]);
+   if (mode == run_mode::CHECK) {
+      if (not args.empty()) return check_files (args, jobs);
+      cerr << "Usage: " << sys_info::execname() << " --check"
+           << " filename..." << endl;
+      return EXIT_FAILURE;
+   }
+   if (mode == run_mode::PACK) {
+      if (args.size() == 1) return pack_scene (args[0], page_file);
+      cerr << "Usage: " << sys_info::execname() << " --pack=pagefile"
+           << " filename" << endl;
+      return EXIT_FAILURE;
+   }
+   bool drawing = mode == run_mode::DRAW;
+   if (not page_file.empty() and not paged_scene::open (page_file)) {
+      return EXIT_FAILURE;
+   }
    if (args.size() == 0) {
-      parsefile ("-", cin);
+      // a page file is scene enough without standard input
+      if (page_file.empty()) parsefile ("-", cin, drawing);
    }else if (args.size() > 1) {
       cerr << "Usage: " << sys_info::execname() << "-@flags"
            << "[filename]" << endl;
@@ -94,13 +224,35 @@ int main (int argc, char** argv) {
          syscall_error (infilename);
       }else {
          DEBUGF ('m', infilename << "(opened OK)");
-         parsefile (infilename, infile);
+         parsefile (infilename, infile, drawing);
+         if (drawing) reloader::watch (infilename);
          // fstream objects auto closed when destroyed
       }
    }
    int status = sys_info::exit_status();
    if (status != 0) return status;
-   window::main();
-   return 0;
+   if (mode == run_mode::EXPORT) {
+      return gdraw::export_image (image_file);
+   }
+   if (mode == run_mode::EXPORT_SVG) {
+      return gdraw::export_svg (image_file);
+   }
+   bool input_ok = true;
+   switch (input) {
+      case input_mode::RECORD:
+         input_ok = input_log::record (input_file);
+         break;
+      case input_mode::REPLAY: case input_mode::REPLAY_FAST:
+         input_ok = input_log::replay
+                    (input_file, input == input_mode::REPLAY_FAST);
+         break;
+      case input_mode::LIVE:
+         break;
+   }
+   if (not input_ok) return EXIT_FAILURE;
+   if (not feed_name.empty() and not position_feed::open (feed_name)) {
+      return EXIT_FAILURE;
+   }
+   gdraw::show();
 }
 
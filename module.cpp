@@ -0,0 +1,277 @@
+// $Id: module.cpp,v 1.1 2026-10-19 12:00:00-07 - - $
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+#include "api.h"
+#include "debug.h"
+#include "interp.h"
+#include "module.h"
+#include "util.h"
+
+unordered_map<uint64_t,module_ptr> module_cache::loaded;
+
+static const char cache_magic[8] {'G','D','I','N','C','0','0','1'};
+enum class cache_kind: uint8_t {SHAPE, INCLUDE};
+
+uint64_t module_cache::hash (const string& text) {
+   uint64_t result = 0xCBF29CE484222325;
+   for (unsigned char byte: text) {
+      result ^= byte;
+      result *= 0x100000001B3;
+   }
+   return result;
+}
+
+// $XDG_CACHE_HOME/gdraw or ~/.cache/gdraw, made if need be, or an
+// empty name if there is no such directory.
+string module_cache::cache_file (uint64_t hash) {
+   static string directory = [] {
+      const char* xdg = getenv ("XDG_CACHE_HOME");
+      const char* home = getenv ("HOME");
+      string base;
+      if (xdg != nullptr and xdg[0] == '/') base = xdg;
+      else if (home != nullptr and home[0] == '/') {
+         base = string (home) + "/.cache";
+         mkdir (base.c_str(), 0700);
+      }else return string();
+      string dir = base + "/gdraw";
+      if (mkdir (dir.c_str(), 0700) < 0 and errno != EEXIST) {
+         return string();
+      }
+      return dir;
+   }();
+   if (directory.empty()) return string();
+   char name[24];
+   snprintf (name, sizeof name, "/%016llx.gdc",
+             static_cast<unsigned long long> (hash));
+   return directory + name;
+}
+
+// The same checks as the interpreter's factories, from numbers.
+shape_ptr module_cache::build (const module::entry& entry) {
+   const string& type = entry.type;
+   const vector<GLfloat>& num = entry.numbers;
+   size_t count = num.size();
+   if (type == "text") return gdraw::make_text (entry.font,
+                                                entry.textdata);
+   if (type == "polygon" or type == "triangle") {
+      if (count < 6 or count % 2 != 0) {
+         throw runtime_error ("syntax error");
+      }
+      vertex_list vertices;
+      vertices.reserve (count / 2);
+      for (size_t coord = 0; coord < count; coord += 2) {
+         vertices.push_back ({num[coord], num[coord + 1]});
+      }
+      return gdraw::make_polygon (move (vertices));
+   }
+   if (type == "ellipse" or type == "rectangle" or type == "diamond") {
+      if (count != 2) throw runtime_error ("syntax error");
+      if (type == "ellipse") {
+         return gdraw::make_ellipse (num[0], num[1]);
+      }
+      if (type == "rectangle") {
+         return gdraw::make_rectangle (num[0], num[1]);
+      }
+      return gdraw::make_diamond (num[0], num[1]);
+   }
+   if (type == "circle" or type == "square" or type == "equilateral") {
+      if (count != 1) throw runtime_error ("syntax error");
+      if (type == "circle") return gdraw::make_circle (num[0]);
+      if (type == "square") return gdraw::make_square (num[0]);
+      return gdraw::make_equilateral (num[0]);
+   }
+   throw runtime_error (type + ": no such shape");
+}
+
+// Each define becomes its numbers and its shape.  Bad lines are
+// reported and skipped, and make the module unfit for the disk.
+module_ptr module_cache::parse (const string& path, const string& text,
+                                bool& clean) {
+   auto result = make_shared<module>();
+   istringstream infile (text);
+   interpreter::parameters words;
+   clean = true;
+   for (int linenr = 1; read_command (infile, words); ++linenr) {
+      if (words.size() == 0) continue;
+      try {
+         module::entry entry;
+         if (words[0] == "include") {
+            if (words.size() != 2) throw runtime_error ("syntax error");
+            entry.type = words[1];
+         }else if (words[0] == "define") {
+            if (words.size() < 4) throw runtime_error ("syntax error");
+            entry.name = words[1];
+            entry.type = words[2];
+            if (entry.type == "text") {
+               if (words.size() < 5) {
+                  throw runtime_error ("syntax error");
+               }
+               entry.font = words[3];
+               entry.textdata = words[4];
+               for (size_t word = 5; word < words.size(); ++word) {
+                  entry.textdata += " " + words[word];
+               }
+            }else {
+               for (size_t word = 3; word < words.size(); ++word) {
+                  entry.numbers.push_back (
+                        from_string<GLfloat> (words[word]));
+               }
+            }
+            entry.pshape = build (entry);
+         }else {
+            throw runtime_error (words[0]
+                                 + ": not allowed in an included file");
+         }
+         result->entries.push_back (move (entry));
+      }catch (exception& error) {
+         complain() << path << ":" << linenr << ": " << error.what()
+                    << endl;
+         clean = false;
+      }
+   }
+   return result;
+}
+
+static void put_string (ostream& out, const string& text) {
+   uint32_t size = text.size();
+   out.write (reinterpret_cast<const char*> (&size), sizeof size);
+   out.write (text.data(), size);
+}
+
+static bool get_string (istream& in, string& text) {
+   uint32_t size = 0;
+   if (not in.read (reinterpret_cast<char*> (&size), sizeof size)) {
+      return false;
+   }
+   text.resize (size);
+   return bool (in.read (&text[0], size));
+}
+
+module_ptr module_cache::read_cache (const string& filename,
+                                     uint64_t hash) {
+   ifstream in (filename, ios::binary);
+   if (in.fail()) return nullptr;
+   char magic[sizeof cache_magic];
+   uint64_t file_hash = 0;
+   uint32_t count = 0;
+   in.read (magic, sizeof magic);
+   in.read (reinterpret_cast<char*> (&file_hash), sizeof file_hash);
+   in.read (reinterpret_cast<char*> (&count), sizeof count);
+   if (not in or memcmp (magic, cache_magic, sizeof magic) != 0
+       or file_hash != hash) return nullptr;
+   auto result = make_shared<module>();
+   try {
+      for (uint32_t index = 0; index < count; ++index) {
+         module::entry entry;
+         cache_kind kind;
+         in.read (reinterpret_cast<char*> (&kind), sizeof kind);
+         if (not get_string (in, entry.name)
+             or not get_string (in, entry.type)) return nullptr;
+         if (kind == cache_kind::SHAPE) {
+            if (entry.type == "text") {
+               if (not get_string (in, entry.font)
+                   or not get_string (in, entry.textdata)) {
+                  return nullptr;
+               }
+            }else {
+               uint32_t numbers = 0;
+               in.read (reinterpret_cast<char*> (&numbers),
+                        sizeof numbers);
+               entry.numbers.resize (numbers);
+               in.read (reinterpret_cast<char*> (entry.numbers.data()),
+                        numbers * sizeof (GLfloat));
+               if (not in) return nullptr;
+            }
+            entry.pshape = build (entry);
+         }else if (kind != cache_kind::INCLUDE) return nullptr;
+         result->entries.push_back (move (entry));
+      }
+   }catch (exception& error) {
+      DEBUGF ('n', filename << ": " << error.what());
+      return nullptr;
+   }
+   return result;
+}
+
+// Written to a temporary file and renamed, so a reader sees all of
+// the file or none of it.
+void module_cache::write_cache (const string& filename, uint64_t hash,
+                                const module& written) {
+   ostringstream out;
+   uint32_t count = written.entries.size();
+   out.write (cache_magic, sizeof cache_magic);
+   out.write (reinterpret_cast<const char*> (&hash), sizeof hash);
+   out.write (reinterpret_cast<const char*> (&count), sizeof count);
+   for (const module::entry& entry: written.entries) {
+      cache_kind kind = entry.pshape == nullptr ? cache_kind::INCLUDE
+                                                : cache_kind::SHAPE;
+      out.write (reinterpret_cast<const char*> (&kind), sizeof kind);
+      put_string (out, entry.name);
+      put_string (out, entry.type);
+      if (kind == cache_kind::INCLUDE) continue;
+      if (entry.type == "text") {
+         put_string (out, entry.font);
+         put_string (out, entry.textdata);
+      }else {
+         uint32_t numbers = entry.numbers.size();
+         out.write (reinterpret_cast<const char*> (&numbers),
+                    sizeof numbers);
+         out.write (reinterpret_cast<const char*>
+                          (entry.numbers.data()),
+                    numbers * sizeof (GLfloat));
+      }
+   }
+   string temporary = filename + "." + to_string (getpid());
+   ofstream file (temporary, ios::binary);
+   const string& bytes = out.str();
+   file.write (bytes.data(), bytes.size());
+   file.close();
+   if (file.fail()
+       or rename (temporary.c_str(), filename.c_str()) < 0) {
+      DEBUGF ('n', filename << ": " << strerror (errno));
+      unlink (temporary.c_str());
+   }
+}
+
+module_ptr module_cache::load (const string& path) {
+   ifstream infile (path, ios::binary);
+   if (infile.fail()) {
+      throw runtime_error (path + ": " + strerror (errno));
+   }
+   string text {istreambuf_iterator<char> (infile),
+                istreambuf_iterator<char>()};
+   uint64_t key = hash (text);
+   auto found = loaded.find (key);
+   if (found != loaded.end()) {
+      DEBUGF ('n', path << ": already parsed");
+      return found->second;
+   }
+   string filename = cache_file (key);
+   module_ptr result;
+   if (not filename.empty()) result = read_cache (filename, key);
+   if (result != nullptr) {
+      DEBUGF ('n', path << ": from " << filename);
+   }else {
+      bool clean = true;
+      result = parse (path, text, clean);
+      DEBUGF ('n', path << ": parsed, clean " << clean);
+      if (clean and not filename.empty()) {
+         write_cache (filename, key, *result);
+      }
+   }
+   loaded.emplace (key, result);
+   return result;
+}
+
@@ -0,0 +1,61 @@
+// $Id: module.h,v 1.1 2026-10-19 12:00:00-07 - - $
+
+//
+// module_cache -
+//    The definitions in files read by include, so that each file
+//    is parsed once.  Files are keyed by the FNV-1a hash of their
+//    contents.  Within a process, a parsed module is kept and its
+//    shapes are shared by every include of the same text.  Across
+//    processes, its definitions are kept already converted to
+//    numbers in $XDG_CACHE_HOME/gdraw, or ~/.cache/gdraw, as
+//    <hash>.gdc, and a later run rebuilds the shapes from those
+//    without reading the text again.  An included file may hold
+//    only define and include lines.  A file with errors is not
+//    cached on disk, and a cache directory that cannot be used is
+//    quietly ignored.
+//
+
+#ifndef __MODULE_H__
+#define __MODULE_H__
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+#include "shape.h"
+
+struct module {
+   struct entry {
+      string name;             // Of the shape, empty for an include.
+      string type;             // Of the shape, or the path included.
+      vector<GLfloat> numbers; // Of any shape but text.
+      string font;             // Of text.
+      string textdata;
+      shape_ptr pshape;
+   };
+   vector<entry> entries;      // In the order of the file.
+};
+using module_ptr = shared_ptr<const module>;
+
+class module_cache {
+   private:
+      static unordered_map<uint64_t,module_ptr> loaded;
+      static string cache_file (uint64_t hash);
+      static module_ptr parse (const string& path, const string& text,
+                               bool& clean);
+      static module_ptr read_cache (const string& filename,
+                                    uint64_t hash);
+      static void write_cache (const string& filename, uint64_t hash,
+                               const module&);
+   public:
+      module_cache() = delete;
+      static uint64_t hash (const string& text);
+      static shape_ptr build (const module::entry&);
+      static module_ptr load (const string& path);
+};
+
+#endif
+
@@ -0,0 +1,509 @@
+// $Id: paged.cpp,v 1.1 2026-10-19 12:00:00-07 - - $
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+using namespace std;
+
+#include <GL/freeglut.h>
+
+#include "debug.h"
+#include "interp.h"
+#include "paged.h"
+#include "util.h"
+
+int paged_scene::fd {-1};
+vector<shape_ptr> paged_scene::shapes;
+vector<paged_scene::page_entry> paged_scene::index;
+unordered_map<uint64_t,size_t> paged_scene::cells;
+int32_t paged_scene::xcell_low {0};
+int32_t paged_scene::xcell_high {-1};
+int32_t paged_scene::ycell_low {0};
+int32_t paged_scene::ycell_high {-1};
+GLfloat paged_scene::reach {0};
+size_t paged_scene::budget {size_t (256) << 20};
+size_t paged_scene::resident_bytes {0};
+uint64_t paged_scene::frame {0};
+unordered_map<size_t,unique_ptr<paged_scene::page>>
+      paged_scene::resident;
+unordered_set<size_t> paged_scene::requested;
+// Never destroyed, since the loader is still waiting at exit.
+mutex& paged_scene::queue_lock = *new mutex;
+condition_variable& paged_scene::wakeup = *new condition_variable;
+deque<size_t> paged_scene::wanted;
+vector<pair<size_t,unique_ptr<paged_scene::page>>> paged_scene::loaded;
+
+static const char magic[8] {'G', 'D', 'P', 'A', 'G', 'E', 'S', '1'};
+static const unsigned poll_msecs = 30;
+static const size_t chunk_records = 65536; // Read or written at once.
+static unordered_set<size_t> near_pages;   // As of the last frame.
+
+//
+// The file is a header, the definitions as .gd text, the page
+// index, and the records of each page in turn, all in the byte
+// order of the machine that packed it.
+//
+
+struct page_header {
+   char magic[8];
+   uint64_t define_bytes;
+   uint64_t page_count;
+   GLfloat reach;
+   GLfloat page_size;
+};
+
+static bool read_at (int fd, void* buffer, size_t size, off_t offset) {
+   char* data = static_cast<char*> (buffer);
+   while (size > 0) {
+      ssize_t got = pread (fd, data, size, offset);
+      if (got < 0 and errno == EINTR) continue;
+      if (got <= 0) return false;
+      data += got;
+      size -= got;
+      offset += got;
+   }
+   return true;
+}
+
+static bool write_at (int fd, const void* buffer, size_t size,
+                      off_t offset) {
+   const char* data = static_cast<const char*> (buffer);
+   while (size > 0) {
+      ssize_t written = pwrite (fd, data, size, offset);
+      if (written < 0) {
+         if (errno == EINTR) continue;
+         return false;
+      }
+      data += written;
+      size -= written;
+      offset += written;
+   }
+   return true;
+}
+
+static int32_t cell_of (GLfloat coord) {
+   return static_cast<int32_t> (floor (coord / paged_scene::page_size));
+}
+
+//
+// One pass over a .gd file for pack_scene, interpreting the
+// definitions as they come, so that each draw sees the same shapes
+// in both passes.  Calls defined for the first definition of each
+// name and placed for each object, including those of grids and
+// repeats.  Included files are read here, line by line, instead of
+// by the interpreter, so that their definitions are written to the
+// page file like any other.  Errors are reported only once, in the
+// first pass.
+//
+
+using placed_fn = interpreter::place_fn;
+using defined_fn = function<void (const interpreter::parameters&)>;
+
+static void pack_lines (const string& filename, istream& infile,
+                        bool first, const defined_fn& defined,
+                        interpreter& interp, vector<string>& chain) {
+   interpreter::parameters words;
+   for (int linenr = 1; read_command (infile, words); ++linenr) {
+      if (words.size() == 0) continue;
+      if (words[0] == "group" or words[0] == "endgroup") continue;
+      try {
+         if (words[0] == "include" and words.size() == 2) {
+            string path = interpreter::resolve (words[1], chain.back());
+            if (std::find (chain.begin(), chain.end(), path)
+                != chain.end()) {
+               throw runtime_error ("include cycle: " + path);
+            }
+            ifstream included (path);
+            if (included.fail()) {
+               throw runtime_error (path + ": " + strerror (errno));
+            }
+            chain.push_back (path);
+            pack_lines (path, included, first, defined, interp, chain);
+            chain.pop_back();
+            continue;
+         }
+         if (chain.size() > 1 and words[0] != "define") {
+            throw runtime_error (words[0]
+                                 + ": not allowed in an included file");
+         }
+         bool fresh = words[0] == "define" and words.size() >= 2
+                      and interpreter::find (words[1]) == nullptr;
+         interp.interpret (words);
+         if (fresh) defined (words);
+      }catch (exception& error) {
+         if (first) {
+            complain() << filename << ":" << linenr << ": "
+                       << error.what() << endl;
+         }
+      }
+   }
+}
+
+static void pack_pass (const string& scene, istream& infile,
+                       bool first, const placed_fn& placed,
+                       const defined_fn& defined) {
+   interpreter interp (false);
+   interpreter::clear();
+   interpreter::set_strict (true);
+   interpreter::set_placer (placed);
+   vector<string> chain {interpreter::resolve (scene, "")};
+   pack_lines (scene, infile, first, defined, interp, chain);
+   if (first and interp.in_repeat()) {
+      complain() << scene << ": missing }" << endl;
+   }
+   interpreter::set_placer (nullptr);
+}
+
+int pack_scene (const string& scene, const string& filename) {
+   ifstream infile (scene);
+   if (infile.fail()) {
+      syscall_error (scene);
+      return EXIT_FAILURE;
+   }
+
+   // First pass: definitions, and the size and bounds of each page.
+   unordered_map<string,uint32_t> names;
+   string defines;
+   map<uint64_t,paged_scene::page_entry> pages;
+   pack_pass (scene, infile, true, [&pages] (const object& obj) {
+      vertex center = obj.get_pos();
+      int32_t xcell = cell_of (center.xpos);
+      int32_t ycell = cell_of (center.ypos);
+      auto& entry = pages.emplace (paged_scene::cell_key (xcell, ycell),
+                                   paged_scene::page_entry {
+                                      xcell, ycell, {}, 0, 0})
+                         .first->second;
+      entry.bounds.merge (obj.bounds());
+      ++entry.count;
+   }, [&names, &defines] (const interpreter::parameters& words) {
+      names.emplace (words[1], names.size());
+      for (const string& word: words) defines += word + " ";
+      defines.back() = '\n';
+   });
+
+   vector<paged_scene::page_entry> index;
+   GLfloat reach = 0;
+   for (const auto& cell: pages) {
+      const paged_scene::page_entry& entry = cell.second;
+      GLfloat xlow = entry.xcell * paged_scene::page_size;
+      GLfloat ylow = entry.ycell * paged_scene::page_size;
+      reach = max ({reach, xlow - entry.bounds.low.xpos,
+                    ylow - entry.bounds.low.ypos,
+                    entry.bounds.high.xpos - xlow - paged_scene::page_size,
+                    entry.bounds.high.ypos - ylow
+                    - paged_scene::page_size});
+      index.push_back (entry);
+   }
+   page_header header;
+   memcpy (header.magic, magic, sizeof magic);
+   header.define_bytes = defines.size();
+   header.page_count = index.size();
+   header.reach = reach;
+   header.page_size = paged_scene::page_size;
+   uint64_t offset = sizeof header + defines.size()
+                   + index.size() * sizeof (paged_scene::page_entry);
+   unordered_map<uint64_t,size_t> page_of;
+   for (size_t page = 0; page < index.size(); ++page) {
+      index[page].offset = offset;
+      offset += index[page].count * sizeof (paged_scene::record);
+      page_of[paged_scene::cell_key (index[page].xcell,
+                                     index[page].ycell)] = page;
+   }
+
+   int outfd = open (filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+                     0666);
+   if (outfd < 0) {
+      syscall_error (filename);
+      return EXIT_FAILURE;
+   }
+   bool ok = write_at (outfd, &header, sizeof header, 0)
+         and write_at (outfd, defines.data(), defines.size(),
+                       sizeof header)
+         and write_at (outfd, index.data(),
+                       index.size() * sizeof (paged_scene::page_entry),
+                       sizeof header + defines.size());
+
+   // Second pass: the records, buffered per page and written out
+   // whenever the buffers get big.
+   vector<uint64_t> written (index.size(), 0);
+   unordered_map<size_t,vector<paged_scene::record>> pending;
+   size_t buffered = 0;
+   auto flush = [&] () {
+      for (auto& buffer: pending) {
+         size_t page = buffer.first;
+         vector<paged_scene::record>& records = buffer.second;
+         ok = ok and write_at (outfd, records.data(),
+                               records.size() * sizeof records[0],
+                               index[page].offset + written[page]
+                               * sizeof (paged_scene::record));
+         written[page] += records.size();
+      }
+      pending.clear();
+      buffered = 0;
+   };
+   infile.clear();
+   infile.seekg (0);
+   unordered_map<const shape*,uint32_t> shape_index; // This pass's.
+   pack_pass (scene, infile, false, [&] (const object& obj) {
+      vertex center = obj.get_pos();
+      size_t page = page_of.at (paged_scene::cell_key (
+                                   cell_of (center.xpos),
+                                   cell_of (center.ypos)));
+      const rgbcolor& color = obj.get_color();
+      pending[page].push_back ({shape_index.at (&obj.get_shape()),
+                                center.xpos, center.ypos,
+                                {color.rgb.red, color.rgb.green,
+                                 color.rgb.blue}, 0});
+      if (++buffered >= chunk_records) flush();
+   }, [&names, &shape_index] (const interpreter::parameters& words) {
+      shape_index.emplace (interpreter::find (words[1]).get(),
+                           names.at (words[1]));
+   });
+   flush();
+   interpreter::clear();
+   if (not ok) syscall_error (filename);
+   if (close (outfd) < 0 and ok) {
+      syscall_error (filename);
+      ok = false;
+   }
+   DEBUGF ('P', filename << ": " << names.size() << " shapes, "
+           << index.size() << " pages, reach " << reach);
+   return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+bool paged_scene::open (const string& filename) {
+   fd = ::open (filename.c_str(), O_RDONLY | O_CLOEXEC);
+   if (fd < 0) {
+      syscall_error (filename);
+      return false;
+   }
+   page_header header;
+   string defines;
+   bool ok = read_at (fd, &header, sizeof header, 0)
+         and memcmp (header.magic, magic, sizeof magic) == 0
+         and header.page_size == page_size;
+   if (ok) {
+      defines.resize (header.define_bytes);
+      index.resize (header.page_count);
+      ok = read_at (fd, &defines[0], defines.size(), sizeof header)
+       and read_at (fd, index.data(), index.size() * sizeof index[0],
+                    sizeof header + defines.size());
+   }
+   if (not ok) {
+      complain() << filename << ": not a page file" << endl;
+      close (fd);
+      fd = -1;
+      return false;
+   }
+   reach = header.reach;
+
+   // Each definition is for the next shape index.
+   interpreter interp (false);
+   istringstream lines (defines);
+   interpreter::parameters words;
+   while (read_command (lines, words)) {
+      if (words.size() < 2) continue;
+      try {
+         interp.interpret (words);
+      }catch (exception& error) {
+         complain() << filename << ": " << error.what() << endl;
+      }
+      shapes.push_back (interpreter::find (words[1]));
+   }
+   for (size_t page = 0; page < index.size(); ++page) {
+      const page_entry& entry = index[page];
+      cells[cell_key (entry.xcell, entry.ycell)] = page;
+      if (page == 0) {
+         xcell_low = xcell_high = entry.xcell;
+         ycell_low = ycell_high = entry.ycell;
+      }
+      xcell_low = min (xcell_low, entry.xcell);
+      xcell_high = max (xcell_high, entry.xcell);
+      ycell_low = min (ycell_low, entry.ycell);
+      ycell_high = max (ycell_high, entry.ycell);
+   }
+   DEBUGF ('P', filename << ": " << shapes.size() << " shapes, "
+           << index.size() << " pages");
+   thread (loader).detach();
+   window::add_timer (poll_msecs, poll);
+   return true;
+}
+
+// Runs in the loader thread.  The queue is built here as well, since
+// it only reads the shapes.
+unique_ptr<paged_scene::page> paged_scene::load (size_t page_index) {
+   const page_entry& entry = index[page_index];
+   unique_ptr<page> result = make_unique<page>();
+   result->objects.reserve (entry.count);
+   vector<record> records;
+   for (uint64_t done = 0; done < entry.count;) {
+      size_t count = min<uint64_t> (chunk_records, entry.count - done);
+      records.resize (count);
+      if (not read_at (fd, records.data(), count * sizeof (record),
+                       entry.offset + done * sizeof (record))) {
+         complain() << "page " << page_index << ": read failed" << endl;
+         break;
+      }
+      for (const record& rec: records) {
+         if (rec.shape >= shapes.size() or shapes[rec.shape] == nullptr) {
+            continue;
+         }
+         object obj;
+         obj.set (shapes[rec.shape], {rec.xpos, rec.ypos},
+                  rgbcolor (rec.rgb[0], rec.rgb[1], rec.rgb[2]));
+         result->objects.push_back (obj);
+      }
+      done += count;
+   }
+   vector<render_queue::item> items;
+   items.reserve (result->objects.size());
+   for (size_t obj = 0; obj < result->objects.size(); ++obj) {
+      items.push_back ({obj, {0, 0}});
+   }
+   result->queue.build (result->objects, items, entry.bounds);
+   result->bytes = sizeof (page)
+                 + result->objects.capacity() * sizeof (object)
+                 + result->queue.bytes();
+   return result;
+}
+
+void paged_scene::loader() {
+   for (;;) {
+      size_t next;
+      {
+         unique_lock<mutex> lock (queue_lock);
+         wakeup.wait (lock, [] () { return not wanted.empty(); });
+         next = wanted.front();
+         wanted.pop_front();
+      }
+      unique_ptr<page> result = load (next);
+      DEBUGF ('P', "page " << next << " loaded, "
+              << result->objects.size() << " objects");
+      lock_guard<mutex> guard (queue_lock);
+      loaded.emplace_back (next, move (result));
+   }
+}
+
+// The cell holding coord, clamped to [low,high].
+static int32_t clamped_cell (GLfloat coord, int32_t low, int32_t high) {
+   GLfloat cell = floor (coord / paged_scene::page_size);
+   if (not (cell > low)) return low;
+   if (cell > high) return high;
+   return int32_t (cell);
+}
+
+// Pages whose objects could overlap area, looked up by cell over the
+// part of the area within the index, or, when that is more cells
+// than there are pages, by going through the index.
+vector<size_t> paged_scene::pages_near (const bbox& area) {
+   vector<size_t> result;
+   if (index.empty()) return result;
+   int32_t xlow = clamped_cell (area.low.xpos - reach,
+                                xcell_low, xcell_high);
+   int32_t ylow = clamped_cell (area.low.ypos - reach,
+                                ycell_low, ycell_high);
+   int32_t xhigh = clamped_cell (area.high.xpos + reach,
+                                 xcell_low, xcell_high);
+   int32_t yhigh = clamped_cell (area.high.ypos + reach,
+                                 ycell_low, ycell_high);
+   uint64_t range = uint64_t (int64_t (xhigh) - xlow + 1)
+                  * uint64_t (int64_t (yhigh) - ylow + 1);
+   if (range > index.size()) {
+      for (size_t page = 0; page < index.size(); ++page) {
+         if (index[page].bounds.overlaps (area)) result.push_back (page);
+      }
+      return result;
+   }
+   for (int32_t ycell = ylow; ycell <= yhigh; ++ycell) {
+      for (int32_t xcell = xlow; xcell <= xhigh; ++xcell) {
+         auto found = cells.find (cell_key (xcell, ycell));
+         if (found == cells.end()) continue;
+         if (index[found->second].bounds.overlaps (area)) {
+            result.push_back (found->second);
+         }
+      }
+   }
+   return result;
+}
+
+// Evict the least recently drawn pages until under budget, but never
+// those near the view, which would only be loaded again.
+void paged_scene::evict (const unordered_set<size_t>& keep) {
+   while (resident_bytes > budget) {
+      auto oldest = resident.end();
+      for (auto page = resident.begin(); page != resident.end(); ++page) {
+         if (keep.count (page->first)) continue;
+         if (oldest == resident.end()
+             or page->second->last_drawn < oldest->second->last_drawn) {
+            oldest = page;
+         }
+      }
+      if (oldest == resident.end()) break;
+      DEBUGF ('P', "page " << oldest->first << " evicted");
+      resident_bytes -= oldest->second->bytes;
+      resident.erase (oldest);
+   }
+}
+
+// Take in the pages loaded since the last poll.
+void paged_scene::poll (int) {
+   vector<pair<size_t,unique_ptr<page>>> arrived;
+   {
+      lock_guard<mutex> guard (queue_lock);
+      arrived.swap (loaded);
+   }
+   for (auto& page: arrived) {
+      requested.erase (page.first);
+      resident_bytes += page.second->bytes;
+      resident[page.first] = move (page.second);
+   }
+   if (not arrived.empty()) {
+      evict (near_pages);
+      glutPostRedisplay();
+   }
+   glutTimerFunc (poll_msecs, poll, 0);
+}
+
+// Ask for the pages within a window of the view that are not here,
+// forgetting earlier requests that are no longer near, then draw the
+// resident pages in view.
+void paged_scene::draw (const bbox& view) {
+   ++frame;
+   GLfloat xmargin = view.high.xpos - view.low.xpos;
+   GLfloat ymargin = view.high.ypos - view.low.ypos;
+   bbox area {{view.low.xpos - xmargin, view.low.ypos - ymargin},
+              {view.high.xpos + xmargin, view.high.ypos + ymargin}};
+   vector<size_t> near = pages_near (area);
+   near_pages = unordered_set<size_t> (near.begin(), near.end());
+   {
+      lock_guard<mutex> guard (queue_lock);
+      for (auto page = wanted.begin(); page != wanted.end();) {
+         if (near_pages.count (*page)) {
+            ++page;
+            continue;
+         }
+         requested.erase (*page);
+         page = wanted.erase (page);
+      }
+      for (size_t page: near) {
+         if (resident.count (page) or requested.count (page)) continue;
+         requested.insert (page);
+         wanted.push_back (page);
+      }
+   }
+   wakeup.notify_one();
+   for (size_t page: pages_near (view)) {
+      auto found = resident.find (page);
+      if (found == resident.end()) continue;
+      found->second->last_drawn = frame;
+      found->second->queue.submit (found->second->objects);
+   }
+}
+
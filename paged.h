@@ -0,0 +1,108 @@
+// $Id: paged.h,v 1.1 2026-10-19 12:00:00-07 - - $
+
+//
+// paged_scene -
+//    Scenes with more objects than fit in memory, browsed from a
+//    page file.  pack_scene turns a .gd file into one in two
+//    streaming passes: the first interprets the definitions and
+//    counts the objects in each page, a square cell of the plane
+//    holding the objects centered in it, and the second writes each
+//    object to its page.  Only the definitions and the page index
+//    stay in memory.
+//
+//    When a page file is open, pages are loaded by a background
+//    thread as they come within one window of the view, and are
+//    drawn after the window's own objects.  Pages no longer near the
+//    view are evicted, least recently drawn first, when the resident
+//    pages exceed the memory budget.  Paged objects can be seen but
+//    not selected or moved; shift+arrows pan the view.  Groups and
+//    settings in the packed file are ignored.  Each page is drawn
+//    whole, in file order, before the next, so where objects from
+//    different pages overlap, file order is not kept between them.
+//
+
+#ifndef __PAGED_H__
+#define __PAGED_H__
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+using namespace std;
+
+#include "graphics.h"
+#include "render.h"
+
+class paged_scene {
+   public:
+      struct record {           // One object, as stored in a page.
+         uint32_t shape;        // Index of its definition.
+         GLfloat xpos;
+         GLfloat ypos;
+         GLubyte rgb[3];
+         GLubyte unused;
+      };
+      struct page_entry {       // Where a page is, and what it covers.
+         int32_t xcell;
+         int32_t ycell;
+         bbox bounds;           // Of all its objects.
+         uint64_t offset;       // Of its records in the file.
+         uint64_t count;
+      };
+      static constexpr GLfloat page_size = 1024;
+   private:
+      struct page {
+         vector<object> objects;
+         render_queue queue;
+         size_t bytes {0};
+         uint64_t last_drawn {0};
+      };
+      static int fd;
+      static vector<shape_ptr> shapes;
+      static vector<page_entry> index;
+      static unordered_map<uint64_t,size_t> cells; // Cell -> page.
+      static int32_t xcell_low, xcell_high; // Of the cells in index.
+      static int32_t ycell_low, ycell_high;
+      static GLfloat reach;      // Farthest any object leaves its cell.
+      static size_t budget;      // Bytes of resident pages.
+      static size_t resident_bytes;
+      static uint64_t frame;
+      static unordered_map<size_t,unique_ptr<page>> resident;
+      static unordered_set<size_t> requested; // Not yet resident.
+      static mutex& queue_lock;  // Guards wanted and loaded.
+      static condition_variable& wakeup;
+      static deque<size_t> wanted;
+      static vector<pair<size_t,unique_ptr<page>>> loaded;
+      static unique_ptr<page> load (size_t page_index);
+      static void loader();
+      static void poll (int);
+      static vector<size_t> pages_near (const bbox& area);
+      static void evict (const unordered_set<size_t>& keep);
+   public:
+      paged_scene() = delete;
+      static uint64_t cell_key (int32_t xcell, int32_t ycell) {
+                  return uint64_t (uint32_t (xcell)) << 32
+                       | uint32_t (ycell); }
+      static void set_budget (size_t megabytes) {
+                  budget = megabytes << 20; }
+      static bool open (const string& filename);
+      static bool active() { return fd >= 0; }
+      static void draw (const bbox& view);
+      static size_t resident_count() { return resident.size(); }
+};
+
+//
+// pack_scene -
+//    Write the page file for a .gd file.  Returns EXIT_SUCCESS or
+//    EXIT_FAILURE.
+//
+
+int pack_scene (const string& scene, const string& filename);
+
+#endif
+
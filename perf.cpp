@@ -0,0 +1,396 @@
+// $Id: perf.cpp,v 1.1 2026-10-19 12:00:00-07 - - $
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <vector>
+using namespace std;
+
+#include "debug.h"
+#include "graphics.h"
+#include "interp.h"
+#include "perf.h"
+#include "util.h"
+
+//
+// Every allocation in the program is counted, so that the parse
+// phase can report how many it made.  The count is one relaxed
+// increment, too cheap to matter outside the benchmark.
+//
+
+static atomic<size_t> allocations {0};
+
+void* operator new (size_t size) {
+   allocations.fetch_add (1, memory_order_relaxed);
+   void* result = malloc (size == 0 ? 1 : size);
+   if (result == nullptr) throw bad_alloc();
+   return result;
+}
+
+void operator delete (void* pointer) noexcept {
+   free (pointer);
+}
+
+void operator delete (void* pointer, size_t) noexcept {
+   free (pointer);
+}
+
+namespace {
+
+using clock_type = chrono::steady_clock;
+using timings = map<string,double>; // "workload/phase" -> ms
+
+// Times in ms, except allocs, the number of allocations in parse.
+const vector<string> phases {"parse", "allocs", "prepare", "teardown"};
+
+const vector<string> bundled {
+   "ellipse-etc.gd", "font-test.gd", "grid.gd", "groups.gd",
+   "movable.gd", "nested.gd", "rectilinear.gd", "rgbcmy.gd",
+};
+
+struct workload {
+   string name;
+   function<string()> scene; // Returns the .gd text to parse.
+};
+
+//
+// Generated scenes, large enough that a 2x slowdown is well above
+// the noise of a single run.
+//
+
+string grid_scene (int count) {
+   ostringstream out;
+   out << "define sq square 10\n" << "define ci circle 10\n"
+       << "define di diamond 10 20\n";
+   const char* names[] {"sq", "ci", "di"};
+   const char* colors[] {"red", "green", "blue", "0x336699"};
+   for (int index = 0; index < count; ++index) {
+      out << "draw " << colors[index % 4] << " " << names[index % 3]
+          << " " << index % 640 << " " << index / 640 % 480 << "\n";
+   }
+   return out.str();
+}
+
+string defines_scene (int count) {
+   ostringstream out;
+   for (int index = 0; index < count; ++index) {
+      out << "define p" << index << " polygon";
+      for (int corner = 0; corner < 8; ++corner) {
+         double theta = corner * M_PI / 4;
+         out << " " << lround (20 * cos (theta)) + index % 7
+             << " " << lround (20 * sin (theta));
+      }
+      out << "\n" << "draw cyan p" << index << " "
+          << index % 640 << " " << index % 480 << "\n";
+   }
+   return out.str();
+}
+
+string big_polygon_scene (int vertices) {
+   ostringstream out;
+   out << "define big polygon";
+   for (int index = 0; index < vertices; ++index) {
+      double theta = 2 * M_PI * index / vertices;
+      out << " " << 200 * cos (theta) << " " << 200 * sin (theta);
+   }
+   out << "\n";
+   for (int index = 0; index < 10; ++index) {
+      out << "draw yellow big " << 320 + index << " 240\n";
+   }
+   return out.str();
+}
+
+vector<workload> workloads() {
+   vector<workload> result;
+   for (const string& filename: bundled) {
+      result.push_back ({filename, [filename]() {
+         ifstream infile (filename);
+         if (infile.fail()) return string();
+         ostringstream text;
+         text << infile.rdbuf();
+         return text.str();
+      }});
+   }
+   result.push_back ({"grid-20000", []() {
+      return grid_scene (20000); }});
+   result.push_back ({"defines-5000", []() {
+      return defines_scene (5000); }});
+   result.push_back ({"polygon-100000", []() {
+      return big_polygon_scene (100000); }});
+   return result;
+}
+
+double elapsed_ms (clock_type::time_point start) {
+   chrono::duration<double,milli> elapsed = clock_type::now() - start;
+   return elapsed.count();
+}
+
+double median (vector<double> values) {
+   sort (values.begin(), values.end());
+   size_t half = values.size() / 2;
+   return values.size() % 2 ? values[half]
+        : (values[half - 1] + values[half]) / 2;
+}
+
+//
+// A fixed piece of work much like a parse: numbers formatted into
+// and scanned out of streams, and a small allocation for each.  Its
+// time is measured alongside the workloads, and the baseline holds
+// their times as multiples of it, so that it holds on a faster or a
+// slower host than the one that recorded it.
+//
+
+double calibrate() {
+   auto start = clock_type::now();
+   ostringstream out;
+   for (int index = 0; index < 20000; ++index) {
+      out << "word" << index << " " << index * 0.25 << "\n";
+   }
+   istringstream in (out.str());
+   vector<unique_ptr<string>> words;
+   map<string,double> numbers;
+   string word;
+   double number;
+   while (in >> word >> number) {
+      words.push_back (make_unique<string> (word));
+      if (words.size() % 16 == 0) numbers[word] = number;
+   }
+   return elapsed_ms (start);
+}
+
+// Median absolute deviation, a spread estimate robust to outliers.
+double deviation (const vector<double>& values) {
+   double middle = median (values);
+   vector<double> spread;
+   for (double value: values) spread.push_back (fabs (value - middle));
+   return median (spread);
+}
+
+//
+// Run each workload runs times, returning the median of each phase
+// and its deviation across the runs, with times in calibration
+// units, and the median time of the calibration in ms.  Each run is
+// measured against the calibration done just before and after it,
+// so that changes in the speed of the host while the runs go on
+// count against both alike.  Diagnostics from the scenes are
+// discarded and do not change the exit status.
+//
+
+void run_workloads (int runs, timings& medians, timings& spreads,
+                    double& unit_ms) {
+   int status = sys_info::exit_status();
+   vector<double> units;
+   for (const workload& work: workloads()) {
+      string scene = work.scene();
+      if (scene.empty()) {
+         cerr << sys_info::execname() << ": " << work.name
+              << ": not found, skipped" << endl;
+         continue;
+      }
+      map<string,vector<double>> samples;
+      units.push_back (calibrate());
+      for (int run = 0; run < runs; ++run) {
+         timings run_ms;
+         istringstream infile (scene);
+         ostringstream discard;
+         streambuf* saved = cerr.rdbuf (discard.rdbuf());
+         size_t allocated = allocations.load (memory_order_relaxed);
+         auto start = clock_type::now();
+         parsefile (work.name, infile, false);
+         run_ms["parse"] = elapsed_ms (start);
+         samples["allocs"].push_back (
+               allocations.load (memory_order_relaxed) - allocated);
+         start = clock_type::now();
+         window::prepare();
+         run_ms["prepare"] = elapsed_ms (start);
+         start = clock_type::now();
+         window::clear();
+         interpreter::clear();
+         run_ms["teardown"] = elapsed_ms (start);
+         cerr.rdbuf (saved);
+         double before = units.back();
+         units.push_back (calibrate());
+         double unit = (before + units.back()) / 2;
+         for (const auto& time: run_ms) {
+            samples[time.first].push_back (time.second / unit);
+         }
+      }
+      for (const string& phase: phases) {
+         medians[work.name + "/" + phase] = median (samples[phase]);
+         spreads[work.name + "/" + phase] = deviation (samples[phase]);
+      }
+      DEBUGF ('p', work.name << " " << runs << " runs");
+   }
+   unit_ms = units.empty() ? 1 : median (units);
+   DEBUGF ('p', "calibration " << unit_ms << " ms");
+   sys_info::exit_status (status);
+}
+
+//
+// Just enough of a JSON reader for the baseline file: nested objects
+// whose leaves are numbers, flattened into keys joined with '/'.
+//
+
+class json_reader {
+   private:
+      istream& in;
+      void expect (char want) {
+         char got;
+         if (not (in >> got) or got != want) {
+            throw runtime_error (string ("expected '") + want + "'");
+         }
+      }
+      string read_string() {
+         expect ('"');
+         string result;
+         for (char next; in.get (next) and next != '"';) {
+            if (next == '\\') in.get (next);
+            result += next;
+         }
+         return result;
+      }
+   public:
+      json_reader (istream& in_): in (in_) {}
+      void read (const string& prefix, timings& values) {
+         char next;
+         if (not (in >> next)) throw runtime_error ("unexpected EOF");
+         in.putback (next);
+         if (next != '{') {
+            double number;
+            if (not (in >> number)) throw runtime_error ("bad number");
+            values[prefix] = number;
+            return;
+         }
+         expect ('{');
+         in >> next;
+         if (next == '}') return;
+         in.putback (next);
+         for (;;) {
+            string key = read_string();
+            expect (':');
+            read (prefix.empty() ? key : prefix + "/" + key, values);
+            in >> next;
+            if (next == '}') break;
+            if (next != ',') throw runtime_error ("expected ','");
+         }
+      }
+};
+
+bool read_baseline (const string& filename, timings& values) {
+   ifstream infile (filename);
+   if (infile.fail()) {
+      syscall_error (filename);
+      return false;
+   }
+   try {
+      json_reader (infile).read ("", values);
+   }catch (runtime_error& error) {
+      complain() << filename << ": " << error.what() << endl;
+      return false;
+   }
+   return true;
+}
+
+} // namespace
+
+int perf_check (const string& baseline) {
+   timings base;
+   if (not read_baseline (baseline, base)) return EXIT_FAILURE;
+   int runs = base.count ("runs") ? static_cast<int> (base["runs"]) : 5;
+   double tolerance = base.count ("tolerance")
+                    ? base["tolerance"] : 0.5;
+   double floor_ms = base.count ("floor_ms") ? base["floor_ms"] : 2;
+   timings medians;
+   timings spreads;
+   double unit_ms = 1;
+   run_workloads (runs, medians, spreads, unit_ms);
+   cout << "calibration " << fixed << setprecision (3) << unit_ms
+        << " ms here";
+   if (base.count ("unit_ms")) {
+      cout << ", " << base["unit_ms"] << " ms where recorded";
+   }
+   cout << endl;
+   int regressions = 0;
+   cout << left << setw (28) << "workload/phase" << right
+        << setw (12) << "median" << setw (12) << "baseline"
+        << setw (12) << "limit" << "  status" << endl;
+   for (const auto& entry: medians) {
+      // Times are compared in calibration units, and shown in ms at
+      // this host's speed; allocations are counted as they are.
+      bool counted = entry.first.substr (entry.first.rfind ('/') + 1)
+                     == "allocs";
+      double scale = counted ? 1 : unit_ms;
+      auto found = base.find ("workloads/" + entry.first);
+      cout << left << setw (28) << entry.first << right
+           << setw (12) << entry.second * scale;
+      if (found == base.end()) {
+         cout << setw (12) << "-" << setw (12) << "-"
+              << "  no baseline" << endl;
+         continue;
+      }
+      // Allow the relative tolerance or the absolute floor, whichever
+      // is larger, plus three deviations of this run's own noise.
+      double limit = max (found->second * (1 + tolerance),
+                          found->second + floor_ms / scale)
+                   + 3 * spreads[entry.first];
+      bool regressed = entry.second > limit;
+      if (regressed) ++regressions;
+      cout << setw (12) << found->second * scale
+           << setw (12) << limit * scale
+           << (regressed ? "  REGRESSED" : "  ok") << endl;
+   }
+   if (regressions > 0) {
+      complain() << regressions << " regression(s) against "
+                 << baseline << endl;
+      return EXIT_FAILURE;
+   }
+   return EXIT_SUCCESS;
+}
+
+int perf_record (const string& baseline) {
+   const int runs = 5;
+   timings medians;
+   timings spreads;
+   double unit_ms = 1;
+   run_workloads (runs, medians, spreads, unit_ms);
+   ofstream outfile (baseline);
+   if (outfile.fail()) {
+      syscall_error (baseline);
+      return EXIT_FAILURE;
+   }
+   outfile << "{\n" << "   \"runs\": " << runs << ",\n"
+           << "   \"tolerance\": 0.5,\n" << "   \"floor_ms\": 2.0,\n"
+           << fixed << setprecision (3)
+           << "   \"unit_ms\": " << unit_ms << ",\n"
+           << "   \"workloads\": {\n";
+   string workname;
+   for (const auto& entry: medians) {
+      size_t slash = entry.first.rfind ('/');
+      string name = entry.first.substr (0, slash);
+      if (name != workname) {
+         if (not workname.empty()) outfile << "\n      },\n";
+         outfile << "      \"" << name << "\": {\n";
+         workname = name;
+      }else {
+         outfile << ",\n";
+      }
+      string phase = entry.first.substr (slash + 1);
+      outfile << "         \"" << phase << "\": "
+              << setprecision (phase == "allocs" ? 0 : 6)
+              << entry.second;
+   }
+   if (not workname.empty()) outfile << "\n      }\n";
+   outfile << "   }\n" << "}\n";
+   cout << sys_info::execname() << ": wrote " << baseline << endl;
+   return EXIT_SUCCESS;
+}
+
@@ -0,0 +1,33 @@
+// $Id: perf.h,v 1.1 2026-10-19 12:00:00-07 - - $
+
+//
+// perf -
+//    Performance regression check.  A fixed set of workloads (the
+//    bundled .gd files and some generated large scenes) is run
+//    through parse, headless draw preparation, and teardown, and
+//    the median times are compared against a checked-in baseline,
+//    along with the number of allocations made by the parse.  The
+//    baseline holds times as multiples of a calibration loop that
+//    is timed in the same run, so it need not be recorded on the
+//    host that checks it.
+//
+
+#ifndef __PERF_H__
+#define __PERF_H__
+
+#include <string>
+using namespace std;
+
+//
+// perf_check -
+//    Run the workloads and compare against the baseline file.
+//    Returns EXIT_SUCCESS if no phase regressed.
+// perf_record -
+//    Run the workloads and write their times as a new baseline.
+//
+
+int perf_check (const string& baseline);
+int perf_record (const string& baseline);
+
+#endif
+
@@ -0,0 +1,286 @@
+// $Id: reload.cpp,v 1.1 2026-10-19 12:00:00-07 - - $
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <fstream>
+#include <sys/inotify.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_set>
+using namespace std;
+
+#include <GL/freeglut.h>
+
+#include "debug.h"
+#include "graphics.h"
+#include "reload.h"
+#include "util.h"
+
+string reloader::filename;
+mutex reloader::pending_lock;
+unique_ptr<reloader::script> reloader::pending;
+bool reloader::resync {false};
+vector<reloader::command> reloader::placed;
+unordered_map<string,size_t> reloader::defines;
+
+static bool loaded {false}; // The first script read is the baseline.
+static const unsigned poll_msecs = 100;
+
+void reloader::watch (const string& filename_) {
+   filename = filename_;
+   thread (watcher).detach();
+   window::add_timer (poll_msecs, poll);
+}
+
+unique_ptr<reloader::script> reloader::read_script() {
+   unique_ptr<script> result = make_unique<script>();
+   ifstream infile (filename);
+   if (infile.fail()) return nullptr;
+   interpreter::parameters words;
+   hash<string> hasher;
+   for (int linenr = 1; read_command (infile, words); ++linenr) {
+      if (words.size() == 0) continue;
+      size_t hash = 0;
+      for (const string& word: words) {
+         hash = hash * 31 + hasher (word);
+      }
+      result->push_back ({linenr, hash, move (words)});
+   }
+   return result;
+}
+
+// Runs in its own thread: wait for the file to be written, then
+// read it and leave it for the window thread to apply.
+void reloader::watcher() {
+   int fd = inotify_init1 (IN_CLOEXEC);
+   if (fd < 0) {
+      syscall_error ("inotify_init1");
+      return;
+   }
+   // Watch the directory, since editors often replace the file.
+   size_t slash = filename.find_last_of ('/');
+   string dirname = slash == string::npos ? "."
+                  : filename.substr (0, slash + 1);
+   string basename = filename.substr (slash + 1);
+   if (inotify_add_watch (fd, dirname.c_str(),
+                          IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+      syscall_error (dirname);
+      close (fd);
+      return;
+   }
+   bool changed = true;
+   for (;;) {
+      if (changed) {
+         unique_ptr<script> commands = read_script();
+         if (commands != nullptr) {
+            DEBUGF ('r', filename << ": " << commands->size()
+                    << " commands read");
+            lock_guard<mutex> guard (pending_lock);
+            pending = move (commands);
+         }
+         changed = false;
+      }
+      alignas (inotify_event) char buffer[4096];
+      ssize_t length = read (fd, buffer, sizeof buffer);
+      if (length < 0) {
+         if (errno == EINTR) continue;
+         syscall_error ("inotify");
+         break;
+      }
+      for (char* next = buffer; next < buffer + length;) {
+         auto event = reinterpret_cast<inotify_event*> (next);
+         if (event->len > 0 and basename == event->name) changed = true;
+         next += sizeof (inotify_event) + event->len;
+      }
+      // Let a burst of writes from the editor settle.
+      if (changed) this_thread::sleep_for (chrono::milliseconds (20));
+   }
+   close (fd);
+}
+
+static void report (const string& filename, int linenr,
+                    const exception& error) {
+   complain() << filename << ":" << linenr << ": " << error.what()
+              << endl;
+}
+
+// Remember what a script placed, after it has been interpreted.
+void reloader::record (const script& commands) {
+   placed.clear();
+   defines.clear();
+   for (const command& cmd: commands) {
+      if (cmd.words[0] == "draw") placed.push_back (cmd);
+      if (cmd.words[0] == "define" and cmd.words.size() >= 2) {
+         defines.emplace (cmd.words[1], cmd.hash);
+      }
+   }
+   resync = placed.size() != window::size();
+}
+
+// Group ranges and offsets do not survive splicing, so a scene
+// with groups is rebuilt from scratch, as is one with repeats or
+// grids, whose commands place more than one object each, or with
+// includes, whose definitions are not in the script.
+void reloader::rebuild (const script& commands) {
+   DEBUGF ('r', "rebuilding " << commands.size() << " commands");
+   interpreter interp (false);
+   window::clear();
+   interpreter::clear();
+   interpreter::push_source (filename);
+   for (const command& cmd: commands) {
+      try {
+         interp.interpret (cmd.words);
+      }catch (exception& error) {
+         report (filename, cmd.linenr, error);
+      }
+   }
+   interpreter::pop_source();
+   if (interp.in_repeat()) {
+      complain() << filename << ": missing }" << endl;
+   }
+   window::close_groups();
+   record (commands);
+}
+
+void reloader::apply (const script& commands) {
+   bool grouped = window::group_count() > 0;
+   for (const command& cmd: commands) {
+      if (cmd.words[0] == "group" or cmd.words[0] == "repeat"
+          or cmd.words[0] == "drawgrid" or cmd.words[0] == "include") {
+         grouped = true;
+      }
+   }
+   if (grouped) {
+      rebuild (commands);
+      return;
+   }
+   interpreter interp (false);
+
+   // Definitions: the first of each name counts, as in do_define.
+   unordered_map<string,size_t> now;
+   unordered_set<string> redefined;
+   vector<const command*> changed;
+   for (const command& cmd: commands) {
+      if (cmd.words[0] != "define" or cmd.words.size() < 2) continue;
+      const string& name = cmd.words[1];
+      if (not now.emplace (name, cmd.hash).second) continue;
+      auto old = defines.find (name);
+      if (old == defines.end() or old->second != cmd.hash) {
+         changed.push_back (&cmd);
+      }
+   }
+   for (const auto& old: defines) {
+      if (now.count (old.first) == 0) {
+         interpreter::undefine (old.first);
+         redefined.insert (old.first);
+      }
+   }
+   for (const command* cmd: changed) {
+      interpreter::undefine (cmd->words[1]);
+      redefined.insert (cmd->words[1]);
+      try {
+         interp.interpret (cmd->words);
+      }catch (exception& error) {
+         report (filename, cmd->linenr, error);
+      }
+   }
+   defines = move (now);
+
+   // Draws: rebuild only the run between the unchanged ends.
+   vector<const command*> draws;
+   for (const command& cmd: commands) {
+      if (cmd.words[0] == "draw") draws.push_back (&cmd);
+   }
+   size_t old_size = placed.size();
+   size_t prefix = 0;
+   size_t suffix = 0;
+   if (not resync) {
+      size_t common = min (old_size, draws.size());
+      while (prefix < common and placed[prefix] == *draws[prefix]) {
+         ++prefix;
+      }
+      while (suffix < common - prefix
+             and placed[old_size - 1 - suffix]
+                 == *draws[draws.size() - 1 - suffix]) ++suffix;
+   }
+   vector<object> objects;
+   vector<command> commands_placed;
+   for (size_t index = prefix; index < draws.size() - suffix; ++index) {
+      const interpreter::parameters& words = draws[index]->words;
+      try {
+         objects.push_back (interpreter::placement (words.cbegin() + 1,
+                                                    words.cend()));
+         commands_placed.push_back (*draws[index]);
+      }catch (exception& error) {
+         report (filename, draws[index]->linenr, error);
+      }
+   }
+   DEBUGF ('r', "prefix " << prefix << ", suffix " << suffix
+           << ", rebuilt " << objects.size());
+   size_t last = resync ? window::size() : old_size - suffix;
+   window::splice (prefix, last, move (objects));
+   placed.erase (placed.begin() + prefix,
+                 placed.begin() + (resync ? old_size : last));
+   placed.insert (placed.begin() + prefix,
+                  make_move_iterator (commands_placed.begin()),
+                  make_move_iterator (commands_placed.end()));
+   resync = false;
+
+   // Objects kept from before must see their shapes' new definitions.
+   if (not redefined.empty()) {
+      for (size_t index = 0; index < placed.size(); ++index) {
+         const string& name = placed[index].words[2];
+         if (redefined.count (name) == 0) continue;
+         shape_ptr pshape = interpreter::find (name);
+         if (pshape != nullptr) window::at (index).set_shape (pshape);
+      }
+      window::invalidate();
+   }
+
+   // Settings: each draw resets the border, so a border command
+   // only counts if it comes after the last draw.
+   int last_draw = -1;
+   int last_border = -1;
+   for (size_t index = 0; index < commands.size(); ++index) {
+      const command& cmd = commands[index];
+      if (cmd.words[0] == "draw") {
+         last_draw = index;
+         continue;
+      }
+      if (cmd.words[0] == "define") continue;
+      if (cmd.words[0] == "border") last_border = index;
+      try {
+         interp.interpret (cmd.words);
+      }catch (exception& error) {
+         report (filename, cmd.linenr, error);
+      }
+   }
+   if (last_draw > last_border) interpreter::default_border();
+}
+
+void reloader::poll (int) {
+   unique_ptr<script> commands;
+   {
+      lock_guard<mutex> guard (pending_lock);
+      commands = move (pending);
+   }
+   if (commands != nullptr) {
+      if (not loaded) {
+         // The scene was already interpreted by parsefile, so only
+         // record what it contains.
+         loaded = true;
+         record (*commands);
+      }else {
+         auto start = chrono::steady_clock::now();
+         apply (*commands);
+         chrono::duration<double,milli> elapsed
+               = chrono::steady_clock::now() - start;
+         DEBUGF ('r', filename << " applied in " << elapsed.count()
+                 << " ms");
+         glutPostRedisplay();
+      }
+   }
+   glutTimerFunc (poll_msecs, poll, 0);
+}
+
@@ -0,0 +1,57 @@
+// $Id: reload.h,v 1.1 2026-10-19 12:00:00-07 - - $
+
+//
+// reloader -
+//    Watches the scene file with inotify.  When it changes, a
+//    background thread re-reads and splits it into commands, and a
+//    window timer applies only the difference to the live scene:
+//    changed definitions replace their shapes, and the draw commands
+//    are compared with the ones already placed, so only the changed
+//    run of objects between the unchanged prefix and suffix is
+//    rebuilt.  Unchanged objects keep their current positions and
+//    the selection stays on the same object.  Scenes with groups,
+//    repeats or grids are rebuilt from scratch instead.
+//
+
+#ifndef __RELOAD_H__
+#define __RELOAD_H__
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+#include "interp.h"
+
+class reloader {
+   private:
+      struct command {
+         int linenr;
+         size_t hash; // Of the words, to compare commands quickly.
+         interpreter::parameters words;
+         bool operator== (const command& that) const {
+            return hash == that.hash and words == that.words;
+         }
+      };
+      using script = vector<command>;
+      static string filename;
+      static mutex pending_lock;
+      static unique_ptr<script> pending; // Read, not yet applied.
+      static bool resync; // Placed draws may not match the window.
+      static vector<command> placed; // Parallel to window objects.
+      static unordered_map<string,size_t> defines; // Name -> hash.
+      static void watcher();
+      static unique_ptr<script> read_script();
+      static void record (const script&);
+      static void rebuild (const script&);
+      static void apply (const script&);
+      static void poll (int);
+   public:
+      reloader() = delete;
+      static void watch (const string& filename);
+};
+
+#endif
+
@@ -0,0 +1,204 @@
+// $Id: render.cpp,v 1.1 2026-10-19 12:00:00-07 - - $
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+using namespace std;
+
+#include <GL/freeglut.h>
+
+#include "debug.h"
+#include "graphics.h"
+#include "hud.h"
+#include "render.h"
+#include "shader.h"
+
+static const GLfloat cell_size = 64; // Of the overlap grid, in pixels.
+static const size_t cell_limit = 16; // Entries checked one by one.
+
+static uint32_t pack (const rgbcolor& color) {
+   return color.rgb.red << 16 | color.rgb.green << 8 | color.rgb.blue;
+}
+
+// How the shape is batched: ellipses are triangles like polygons
+// unless the shader draws them.
+static primitive batch_kind (const shape& form) {
+   primitive kind = form.kind();
+   if (kind == primitive::ELLIPSE and not ellipse_shader::enabled()) {
+      return primitive::TRIANGLES;
+   }
+   return kind;
+}
+
+// Both would be drawn in the same batch, so their order is moot.
+static bool same_state (primitive kind1, uint32_t color1,
+                        primitive kind2, uint32_t color2) {
+   return kind1 != primitive::BITMAP and kind1 == kind2
+      and color1 == color2;
+}
+
+// One cell of the overlap grid.  Past the first cell_limit entries,
+// those of each state are kept only as their highest layer and their
+// merged bounds, so that objects piled on one spot cost no more than
+// a few checks each.  Only the highest layer below a new entry counts,
+// so this can put it higher than it need be, never lower.
+namespace {
+   struct crowd {
+      primitive kind;
+      uint32_t color;
+      uint32_t layer;
+      bbox bounds;
+   };
+   struct cell_entries {
+      vector<size_t> entries;
+      vector<crowd> crowds;
+   };
+}
+
+void render_queue::build (const vector<object>& objects,
+                          const vector<item>& visible,
+                          const bbox& view) {
+   entries.clear();
+   entries.reserve (visible.size());
+   vector<bbox> boxes;
+   boxes.reserve (visible.size());
+   unordered_map<uint64_t,cell_entries> grid;
+   vector<size_t> seen (visible.size(), SIZE_MAX);
+   for (size_t pos = 0; pos < visible.size(); ++pos) {
+      const object& obj = objects[visible[pos].index];
+      entry next {0, batch_kind (obj.get_shape()),
+                  pack (obj.get_color()), visible[pos].index,
+                  visible[pos].offset};
+
+      // Only overlaps within the view can be seen.
+      bbox box = obj.bounds() + next.offset;
+      box.low.xpos = max (box.low.xpos, view.low.xpos);
+      box.low.ypos = max (box.low.ypos, view.low.ypos);
+      box.high.xpos = min (box.high.xpos, view.high.xpos);
+      box.high.ypos = min (box.high.ypos, view.high.ypos);
+      boxes.push_back (box);
+      if (box.empty() or box.low.ypos > box.high.ypos) {
+         entries.push_back (next);
+         continue;
+      }
+      uint64_t xlow = (box.low.xpos - view.low.xpos) / cell_size;
+      uint64_t ylow = (box.low.ypos - view.low.ypos) / cell_size;
+      uint64_t xhigh = (box.high.xpos - view.low.xpos) / cell_size;
+      uint64_t yhigh = (box.high.ypos - view.low.ypos) / cell_size;
+      for (uint64_t xcell = xlow; xcell <= xhigh; ++xcell) {
+         for (uint64_t ycell = ylow; ycell <= yhigh; ++ycell) {
+            cell_entries& cell = grid[xcell << 32 | ycell];
+            for (size_t other: cell.entries) {
+               if (seen[other] == pos) continue;
+               seen[other] = pos;
+               if (not box.overlaps (boxes[other])) continue;
+               const entry& below = entries[other];
+               uint32_t layer = below.layer;
+               if (not same_state (below.kind, below.color,
+                                   next.kind, next.color)) ++layer;
+               next.layer = max (next.layer, layer);
+            }
+            for (const crowd& below: cell.crowds) {
+               if (not box.overlaps (below.bounds)) continue;
+               uint32_t layer = below.layer;
+               if (not same_state (below.kind, below.color,
+                                   next.kind, next.color)) ++layer;
+               next.layer = max (next.layer, layer);
+            }
+         }
+      }
+      // A crowd needs the layer, so the entry goes in the cells after.
+      for (uint64_t xcell = xlow; xcell <= xhigh; ++xcell) {
+         for (uint64_t ycell = ylow; ycell <= yhigh; ++ycell) {
+            cell_entries& cell = grid[xcell << 32 | ycell];
+            if (cell.entries.size() < cell_limit) {
+               cell.entries.push_back (pos);
+               continue;
+            }
+            auto found = find_if (cell.crowds.begin(),
+                                  cell.crowds.end(),
+                                  [&next] (const crowd& each) {
+               return each.kind == next.kind
+                  and each.color == next.color;
+            });
+            if (found == cell.crowds.end()) {
+               cell.crowds.push_back ({next.kind, next.color,
+                                       next.layer, box});
+            }else {
+               found->layer = max (found->layer, next.layer);
+               found->bounds.merge (box);
+            }
+         }
+      }
+      entries.push_back (next);
+   }
+   stable_sort (entries.begin(), entries.end(),
+                [] (const entry& one, const entry& two) {
+      if (one.layer != two.layer) return one.layer < two.layer;
+      if (one.kind != two.kind) return one.kind < two.kind;
+      return one.color < two.color;
+   });
+   batches = 0;
+   for (size_t pos = 0; pos < entries.size(); ++pos) {
+      if (pos == 0 or not same_state (entries[pos - 1].kind,
+                                      entries[pos - 1].color,
+                                      entries[pos].kind,
+                                      entries[pos].color)) ++batches;
+   }
+   valid = true;
+   DEBUGF ('q', entries.size() << " objects in " << batches
+           << " batches");
+}
+
+// Consecutive entries of the same state go in one glBegin/glEnd,
+// even across layers, since the entries are already in layer order.
+// Ellipses are only kept apart, as quads for the shader, when it is
+// enabled.
+void render_queue::submit (vector<object>& objects) const {
+   bool open = false;
+   primitive kind = primitive::BITMAP;
+   uint32_t color = 0;
+   size_t vertices = 0; // In the open batch.
+   auto close = [&] () {
+      if (not open) return;
+      hud::count (vertices);
+      vertices = 0;
+      if (kind == primitive::ELLIPSE) {
+         ellipse_shader::end_fill();
+      }else {
+         glEnd();
+      }
+      open = false;
+   };
+   for (const entry& next: entries) {
+      object& obj = objects[next.index];
+      if (next.kind == primitive::BITMAP) {
+         close();
+         obj.draw (next.offset);
+         continue;
+      }
+      if (not open or next.kind != kind or next.color != color) {
+         close();
+         glColor3ubv (obj.get_color().ubvec);
+         if (next.kind == primitive::ELLIPSE) {
+            ellipse_shader::begin_fill();
+         }else {
+            glBegin (GL_TRIANGLES);
+         }
+         open = true;
+         kind = next.kind;
+         color = next.color;
+      }
+      vertex center = obj.get_pos();
+      center.xpos += next.offset.xpos;
+      center.ypos += next.offset.ypos;
+      if (kind == primitive::ELLIPSE) {
+         ellipse_shader::fill (center, obj.get_shape().bounds().high);
+         vertices += 4;
+         continue;
+      }
+      vertices += obj.get_shape().fill (center);
+   }
+   close();
+}
+
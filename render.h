@@ -0,0 +1,51 @@
+// $Id: render.h,v 1.1 2026-10-19 12:00:00-07 - - $
+
+//
+// render_queue -
+//    The objects in view, sorted by (layer, primitive, color) so that
+//    objects of the same color are drawn with one glBegin/glEnd.
+//    Painter's order is kept where it matters: an object goes in a
+//    later layer than every earlier object it overlaps that is drawn
+//    differently.  Objects that do not overlap may be reordered.
+//    Overlaps are found with a uniform grid over the window.  The
+//    queue is rebuilt only after the scene changes.  Ellipses are
+//    batched as quads for ellipse_shader when it is enabled.
+//
+
+#ifndef __RENDER_H__
+#define __RENDER_H__
+
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+#include "shape.h"
+
+class object;
+
+class render_queue {
+   private:
+      struct entry {
+         uint32_t layer;
+         primitive kind;
+         uint32_t color; // Packed RGB.
+         size_t index;   // Into window::objects.
+         vertex offset;  // Of the groups containing the object.
+      };
+      vector<entry> entries;
+      size_t batches {0};
+      bool valid {false};
+   public:
+      struct item { size_t index; vertex offset; };
+      void build (const vector<object>& objects,
+                  const vector<item>& visible, const bbox& view);
+      void submit (vector<object>& objects) const;
+      void invalidate() { valid = false; }
+      bool is_valid() const { return valid; }
+      size_t size() const { return entries.size(); }
+      size_t batch_count() const { return batches; }
+      size_t bytes() const { return entries.capacity() * sizeof (entry); }
+};
+
+#endif
+
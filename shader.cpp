@@ -0,0 +1,146 @@
+// $Id: shader.cpp,v 1.1 2026-10-19 12:00:00-07 - - $
+
+// Must precede the first GL header to declare the GL 2.0 functions.
+#define GL_GLEXT_PROTOTYPES
+
+#include <iostream>
+#include <string>
+using namespace std;
+
+#include <GL/freeglut.h>
+
+#include "debug.h"
+#include "hud.h"
+#include "shader.h"
+#include "util.h"
+
+bool ellipse_shader::requested {false};
+unsigned ellipse_shader::program {0};
+int ellipse_shader::ring_location {-1};
+
+// Texture coordinates are in units of the semi-axes, so the ellipse
+// is the unit circle.
+static const char* vertex_source = R"(
+#version 120
+void main() {
+   gl_TexCoord[0] = gl_MultiTexCoord0;
+   gl_FrontColor = gl_Color;
+   gl_Position = ftransform();
+}
+)";
+
+// dist is the distance in pixels outside the ellipse, estimated
+// from the screen-space gradient of the radius.
+static const char* fragment_source = R"(
+#version 120
+uniform float ring;
+void main() {
+   float radius = length (gl_TexCoord[0].xy);
+   vec2 gradient = vec2 (dFdx (radius), dFdy (radius));
+   float dist = (radius - 1.0) / max (length (gradient), 1e-6);
+   if (ring > 0.0) {
+      if (abs (dist) > ring * 0.5) discard;
+      gl_FragColor = gl_Color;
+   }else {
+      float alpha = clamp (0.5 - dist, 0.0, 1.0);
+      if (alpha <= 0.0) discard;
+      gl_FragColor = vec4 (gl_Color.rgb, alpha);
+   }
+}
+)";
+
+static GLuint compile (GLenum type, const char* source) {
+   GLuint shader = glCreateShader (type);
+   glShaderSource (shader, 1, &source, nullptr);
+   glCompileShader (shader);
+   GLint status = GL_FALSE;
+   glGetShaderiv (shader, GL_COMPILE_STATUS, &status);
+   if (status != GL_TRUE) {
+      char log[1024] {};
+      glGetShaderInfoLog (shader, sizeof log, nullptr, log);
+      cerr << sys_info::execname() << ": shader: " << log << endl;
+      glDeleteShader (shader);
+      return 0;
+   }
+   return shader;
+}
+
+void ellipse_shader::init() {
+   if (not requested) return;
+   const GLubyte* version = glGetString (GL_SHADING_LANGUAGE_VERSION);
+   DEBUGF ('h', "GLSL " << (version ? reinterpret_cast<const char*>
+                            (version) : "none"));
+   if (version == nullptr) {
+      cerr << sys_info::execname()
+           << ": no GLSL, drawing ellipses as polygons" << endl;
+      return;
+   }
+   GLuint vertex_shader = compile (GL_VERTEX_SHADER, vertex_source);
+   GLuint fragment_shader = compile (GL_FRAGMENT_SHADER,
+                                     fragment_source);
+   if (vertex_shader == 0 or fragment_shader == 0) return;
+   GLuint linked = glCreateProgram();
+   glAttachShader (linked, vertex_shader);
+   glAttachShader (linked, fragment_shader);
+   glLinkProgram (linked);
+   glDeleteShader (vertex_shader);
+   glDeleteShader (fragment_shader);
+   GLint status = GL_FALSE;
+   glGetProgramiv (linked, GL_LINK_STATUS, &status);
+   if (status != GL_TRUE) {
+      cerr << sys_info::execname() << ": shader link failed" << endl;
+      glDeleteProgram (linked);
+      return;
+   }
+   program = linked;
+   ring_location = glGetUniformLocation (program, "ring");
+}
+
+// A quad around the ellipse, pad pixels bigger on every side.
+void ellipse_shader::emit (const vertex& center, const vertex& radii,
+                           GLfloat pad) {
+   if (radii.xpos <= 0 or radii.ypos <= 0) return;
+   GLfloat xscale = 1 + pad / radii.xpos;
+   GLfloat yscale = 1 + pad / radii.ypos;
+   GLfloat xsize = radii.xpos + pad;
+   GLfloat ysize = radii.ypos + pad;
+   glTexCoord2f (-xscale, -yscale);
+   glVertex2f (center.xpos - xsize, center.ypos - ysize);
+   glTexCoord2f (xscale, -yscale);
+   glVertex2f (center.xpos + xsize, center.ypos - ysize);
+   glTexCoord2f (xscale, yscale);
+   glVertex2f (center.xpos + xsize, center.ypos + ysize);
+   glTexCoord2f (-xscale, yscale);
+   glVertex2f (center.xpos - xsize, center.ypos + ysize);
+}
+
+void ellipse_shader::begin_fill() {
+   glUseProgram (program);
+   glUniform1f (ring_location, 0);
+   glEnable (GL_BLEND);
+   glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+   glBegin (GL_QUADS);
+}
+
+void ellipse_shader::fill (const vertex& center, const vertex& radii) {
+   emit (center, radii, 1);
+}
+
+void ellipse_shader::end_fill() {
+   glEnd();
+   glDisable (GL_BLEND);
+   glUseProgram (0);
+}
+
+void ellipse_shader::ring (const vertex& center, const vertex& radii,
+                           const rgbcolor& color, GLfloat thickness) {
+   glUseProgram (program);
+   glUniform1f (ring_location, thickness);
+   glColor3ubv (color.ubvec);
+   glBegin (GL_QUADS);
+   emit (center, radii, thickness / 2 + 1);
+   glEnd();
+   hud::count (4);
+   glUseProgram (0);
+}
+
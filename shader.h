@@ -0,0 +1,39 @@
+// $Id: shader.h,v 1.1 2026-10-19 12:00:00-07 - - $
+
+//
+// ellipse_shader -
+//    Optional GLSL path that draws each ellipse as one quad.  The
+//    fragment shader evaluates the ellipse equation, so the fill is
+//    exact and antialiased at any size, and the selection border is
+//    a ring of the border thickness.  Needs GLSL 1.20, which Mesa's
+//    llvmpipe provides; if the program cannot be built, ellipses are
+//    drawn as polygons as before.
+//
+
+#ifndef __SHADER_H__
+#define __SHADER_H__
+
+#include "rgbcolor.h"
+#include "shape.h"
+
+class ellipse_shader {
+   private:
+      static bool requested;
+      static unsigned program;
+      static int ring_location;
+      static void emit (const vertex& center, const vertex& radii,
+                        GLfloat pad);
+   public:
+      ellipse_shader() = delete;
+      static void request() { requested = true; }
+      static void init(); // After the GL context exists.
+      static bool enabled() { return program != 0; }
+      static void begin_fill();
+      static void fill (const vertex& center, const vertex& radii);
+      static void end_fill();
+      static void ring (const vertex& center, const vertex& radii,
+                        const rgbcolor& color, GLfloat thickness);
+};
+
+#endif
+
@@ -1,5 +1,8 @@
 // $Id: shape.cpp,v 1.2 2019-02-28 15:24:20-08 - - $
 
+// Must precede the first GL header to declare glWindowPos2i.
+#define GL_GLEXT_PROTOTYPES
+
 #include <typeinfo>
 #include <unordered_map>
 #include <cmath>
@@ -7,10 +10,13 @@ using namespace std;
 
 #include <GL/freeglut.h> // might not need
 #include "graphics.h"
+#include "hud.h"
 #include <stdio.h>
 #include "interp.h"
 
 #include "shape.h"
+#include "stroke.h"
+#include "svg.h"
 #include "util.h"
 
 static unordered_map<void*,string> fontname {
@@ -33,6 +39,11 @@ static unordered_map<string,void*> fontcode {
    {"Times-Roman-24", GLUT_BITMAP_TIMES_ROMAN_24},
 };
 
+void* bitmap_font (const string& name) {
+   auto itor = fontcode.find (name);
+   return itor == fontcode.end() ? nullptr : itor->second;
+}
+
 ostream& operator<< (ostream& out, const vertex& where) {
    out << "(" << where.xpos << "," << where.ypos << ")";
    return out;
@@ -56,12 +67,67 @@ circle::circle (GLfloat diameter): ellipse (diameter, diameter) {
    DEBUGF ('c', this);
 }
 
-polygon::polygon (const vertex_list& vertices_): vertices(vertices_) {
+polygon::polygon (vertex_list&& vertices_): vertices (move (vertices_)) {
+   DEBUGF ('c', this);
+   for (const vertex& point: vertices) {
+      centroid.xpos += point.xpos;
+      centroid.ypos += point.ypos;
+      box.merge ({point, point});
+   }
+   if (vertices.empty()) return;
+   centroid.xpos /= vertices.size();
+   centroid.ypos /= vertices.size();
+   box = box + vertex {-centroid.xpos, -centroid.ypos};
+   if (not compact_vertices) return;
+
+   // Rounding to the nearest step is off by half a step at most.
+   quantum = {(box.high.xpos - box.low.xpos) / packed_steps,
+              (box.high.ypos - box.low.ypos) / packed_steps};
+   if (max (quantum.xpos, quantum.ypos) / 2 > 0.5) return;
+   packed.reserve (vertices.size());
+   for (const vertex& point: vertices) {
+      GLfloat xstep = quantum.xpos == 0 ? 0
+            : (point.xpos - centroid.xpos - box.low.xpos) / quantum.xpos;
+      GLfloat ystep = quantum.ypos == 0 ? 0
+            : (point.ypos - centroid.ypos - box.low.ypos) / quantum.ypos;
+      packed.push_back ({uint16_t (lround (xstep)),
+                         uint16_t (lround (ystep))});
+   }
+   vertex_list().swap (vertices);
+}
+
+bool polygon::compact_vertices {false};
+
+vertex polygon::relative (size_t index) const {
+   if (packed.empty()) {
+      return {vertices[index].xpos - centroid.xpos,
+              vertices[index].ypos - centroid.ypos};
+   }
+   return {box.low.xpos + packed[index].xpos * quantum.xpos,
+           box.low.ypos + packed[index].ypos * quantum.ypos};
+}
+
+// The vertices as given, or as near as packing kept them.
+vertex_list polygon::unpacked() const {
+   if (packed.empty()) return vertices;
+   vertex_list points;
+   points.reserve (packed.size());
+   for (size_t index = 0; index < packed.size(); ++index) {
+      vertex point = relative (index);
+      points.push_back ({centroid.xpos + point.xpos,
+                         centroid.ypos + point.ypos});
+   }
+   return points;
+}
+
+template <size_t N>
+fixed_polygon<N>::fixed_polygon (const coords& vertices_):
+      vertices (vertices_), centroid (centroid_of (vertices_)) {
    DEBUGF ('c', this);
 }
 
 rectangle::rectangle (GLfloat width, GLfloat height):
-            polygon( make_coords(width, height)) {
+            fixed_polygon( make_coords(width, height)) {
    DEBUGF ('c', this << "(" << width << "," << height << ")");
 }
 
@@ -70,15 +136,63 @@ square::square (GLfloat width): rectangle (width, width) {
 }
 
 equilateral::equilateral (GLfloat width): 
-      polygon( make_coords(width)  ) {
+      fixed_polygon( make_coords(width)  ) {
    DEBUGF ('c', this);
 }
 
 diamond::diamond (GLfloat width, GLfloat height):
-            polygon( make_coords(width, height)  ) {
+            fixed_polygon( make_coords(width, height)  ) {
    DEBUGF ('c', this << "(" << width << "," << height << ")");
 }
 
+void bbox::merge (const bbox& that) {
+   low.xpos = min (low.xpos, that.low.xpos);
+   low.ypos = min (low.ypos, that.low.ypos);
+   high.xpos = max (high.xpos, that.high.xpos);
+   high.ypos = max (high.ypos, that.high.ypos);
+}
+
+bbox bbox::operator+ (const vertex& offset) const {
+   return {{low.xpos + offset.xpos, low.ypos + offset.ypos},
+           {high.xpos + offset.xpos, high.ypos + offset.ypos}};
+}
+
+bool bbox::overlaps (const bbox& that) const {
+   return low.xpos <= that.high.xpos and that.low.xpos <= high.xpos
+      and low.ypos <= that.high.ypos and that.low.ypos <= high.ypos;
+}
+
+bool bbox::contains (const vertex& point) const {
+   return low.xpos <= point.xpos and point.xpos <= high.xpos
+      and low.ypos <= point.ypos and point.ypos <= high.ypos;
+}
+
+// Glyph cell sizes of the bitmap fonts, so that text can be bounded
+// without asking GLUT, which may not be initialized.
+static unordered_map<void*,vertex> fontcell {
+   {GLUT_BITMAP_8_BY_13       , { 8, 13}},
+   {GLUT_BITMAP_9_BY_15       , { 9, 15}},
+   {GLUT_BITMAP_HELVETICA_10  , { 6, 13}},
+   {GLUT_BITMAP_HELVETICA_12  , { 7, 15}},
+   {GLUT_BITMAP_HELVETICA_18  , {10, 22}},
+   {GLUT_BITMAP_TIMES_ROMAN_10, { 6, 13}},
+   {GLUT_BITMAP_TIMES_ROMAN_24, {13, 28}},
+};
+
+vertex text::window_origin {0, 0};
+
+bbox text::bounds() const {
+   vertex cell = fontcell[glut_bitmap_font];
+   return {{0, -cell.ypos / 4},
+           {cell.xpos * textdata.size(), cell.ypos}};
+}
+
+bbox ellipse::bounds() const {
+   GLfloat w = dimension.xpos / 3;
+   GLfloat h = dimension.ypos / 3;
+   return {{-w, -h}, {w, h}};
+}
+
 void text::draw (const vertex& center, const rgbcolor& color) const {
    DEBUGF ('d', this << "(" << center << "," << color << ")");
 
@@ -86,9 +200,18 @@ void text::draw (const vertex& center, const rgbcolor& color) const {
    auto ubytes = reinterpret_cast<const GLubyte*>
                       (textdata.c_str());
 
+   // A raster position outside the viewport would drop the whole
+   // string, even the part inside, as when a tile of an export cuts
+   // it.  So start at the window origin, which is always valid, and
+   // move to the text with an empty bitmap.
+   GLfloat xwin = center.xpos - window_origin.xpos;
+   GLfloat ywin = center.ypos - window_origin.ypos;
+
    glColor3ubv(color.ubvec);
-   glRasterPos2f(center.xpos, center.ypos);
+   glWindowPos2i (0, 0);
+   glBitmap (0, 0, 0, 0, xwin, ywin, nullptr);
    glutBitmapString (font, ubytes);
+   hud::count (0);
 
 }
 
@@ -99,19 +222,6 @@ void ellipse::draw (const vertex& center, const rgbcolor& color) const {
    float w = dimension.xpos / 3;
    float h = dimension.ypos / 3;
 
-   // draw border if selected
-   if(window::is_selected()) {
-      glColor3ubv(window::get_border().ubvec);
-      glLineWidth(window::get_thick());
-      glBegin (GL_LINE_LOOP);
-      for (float theta = 0; theta < 2 * M_PI; theta += delta) {
-         float xpos = w * cos (theta) + center.xpos;
-         float ypos = h * sin (theta) + center.ypos;
-         glVertex2f (xpos, ypos);
-      }
-      glEnd();
-   }
-
    // draw ellipse
    glColor3ubv (color.ubvec);
    glBegin (GL_POLYGON);
@@ -122,46 +232,265 @@ void ellipse::draw (const vertex& center, const rgbcolor& color) const {
    }
    
    glEnd();
+   hud::count (32);
 }
 
 void polygon::draw (const vertex& center, const rgbcolor& color) const {
    DEBUGF ('d', this << "(" << center << "," << color << ")");
+   glColor3ubv (color.ubvec);
+   glBegin (GL_TRIANGLES);
+   hud::count (fill (center));
+   glEnd();
+}
 
-   // calculate center of polygon
-   GLfloat avg_x = 0; 
-   GLfloat avg_y = 0; 
-
-   for(unsigned int i = 0; i < vertices.size(); ++i) {
-      avg_x += vertices[i].xpos; 
-      avg_y += vertices[i].ypos; 
+// Packed polygons keep no fan of floats, which would take more than
+// packing saves.  Their fan is decoded from the steps, or from the
+// chosen level of detail, each time it is drawn.
+size_t polygon::fill (const vertex& center) const {
+   if (packed.empty()) return shape::fill (center);
+   const vertex_list& points = detail (1);
+   bool decode = &points == &vertices;
+   size_t count = decode ? packed.size() : points.size();
+   auto emit = [&] (size_t index) {
+      vertex point = decode ? relative (index)
+                    : vertex {points[index].xpos - centroid.xpos,
+                              points[index].ypos - centroid.ypos};
+      glVertex2f (center.xpos + point.xpos, center.ypos + point.ypos);
+   };
+   for (size_t index = 2; index < count; ++index) {
+      emit (0);
+      emit (index - 1);
+      emit (index);
    }
-   
-   avg_x /= vertices.size();
-   avg_y /= vertices.size();
-
-   // draw border if selected
-   if(window::is_selected()) {
-      glColor3ubv(window::get_border().ubvec);
-      glLineWidth(window::get_thick());
-
-      glBegin (GL_LINE_LOOP);
-      for(unsigned int i = 0; i < vertices.size(); ++i) {
-         glVertex2f (center.xpos + (vertices[i].xpos-avg_x), 
-               center.ypos + (vertices[i].ypos-avg_y));
+   return count > 2 ? 3 * (count - 2) : 0;
+}
+
+// Border strips are tessellated once per thickness and reused.
+// Preparing does no GL calls, so it may be done without a window.
+void shape::prepare (GLfloat thickness) const {
+   if (caches_fill()) triangles();
+   if (thickness == border_thickness) return;
+   border_strip = tessellate_stroke (outline(), thickness);
+   border_thickness = thickness;
+}
+
+// The outline of a convex shape, as a fan of triangles.
+const vertex_list& shape::triangles() const {
+   if (not filled) {
+      vertex_list points = outline();
+      fill_triangles.reserve (points.size() > 2
+                              ? 3 * (points.size() - 2) : 0);
+      for (size_t index = 2; index < points.size(); ++index) {
+         fill_triangles.push_back (points[0]);
+         fill_triangles.push_back (points[index - 1]);
+         fill_triangles.push_back (points[index]);
       }
-      glEnd();
+      filled = true;
    }
+   return fill_triangles;
+}
 
-   // draw polygon
-   glColor3ubv (color.ubvec);
-   glBegin (GL_POLYGON);
-   for(unsigned int i = 0; i < vertices.size(); ++i) {
-      glVertex2f (center.xpos + (vertices[i].xpos-avg_x), 
-            center.ypos + (vertices[i].ypos-avg_y));
+size_t shape::fill (const vertex& center) const {
+   const vertex_list& fan = triangles();
+   for (const vertex& point: fan) {
+      glVertex2f (center.xpos + point.xpos, center.ypos + point.ypos);
+   }
+   return fan.size();
+}
+
+void shape::draw_border (const vertex& center, const rgbcolor& color,
+                         GLfloat thickness) const {
+   DEBUGF ('d', this << "(" << center << "," << color << ","
+           << thickness << ")");
+   prepare (thickness);
+   draw_strip (border_strip, center, color);
+}
+
+vertex_list ellipse::outline() const {
+   const int segments = 32;
+   const float delta = 2 * M_PI / segments;
+   float w = dimension.xpos / 3;
+   float h = dimension.ypos / 3;
+   vertex_list points;
+   points.reserve (segments);
+   for (int segment = 0; segment < segments; ++segment) {
+      float theta = segment * delta;
+      points.push_back ({w * cosf (theta), h * sinf (theta)});
    }
+   return points;
+}
+
+template <size_t N>
+void fixed_polygon<N>::draw (const vertex& center,
+                             const rgbcolor& color) const {
+   DEBUGF ('d', this << "(" << center << "," << color << ")");
+   glColor3ubv (color.ubvec);
+   glBegin (GL_TRIANGLES);
+   hud::count (fill (center));
    glEnd();
 }
 
+// The fan straight from the vertices, with nothing kept on the heap.
+template <size_t N>
+size_t fixed_polygon<N>::fill (const vertex& center) const {
+   GLfloat xpos = center.xpos - centroid.xpos;
+   GLfloat ypos = center.ypos - centroid.ypos;
+   for (size_t index = 2; index < N; ++index) {
+      glVertex2f (xpos + vertices[0].xpos, ypos + vertices[0].ypos);
+      glVertex2f (xpos + vertices[index - 1].xpos,
+                  ypos + vertices[index - 1].ypos);
+      glVertex2f (xpos + vertices[index].xpos,
+                  ypos + vertices[index].ypos);
+   }
+   return 3 * (N - 2);
+}
+
+template <size_t N>
+bbox fixed_polygon<N>::bounds() const {
+   bbox box;
+   for (size_t index = 0; index < N; ++index) {
+      vertex point {vertices[index].xpos - centroid.xpos,
+                    vertices[index].ypos - centroid.ypos};
+      box.merge ({point, point});
+   }
+   return box;
+}
+
+template <size_t N>
+vertex_list fixed_polygon<N>::outline() const {
+   vertex_list points (N);
+   for (size_t index = 0; index < N; ++index) {
+      points[index] = {vertices[index].xpos - centroid.xpos,
+                       vertices[index].ypos - centroid.ypos};
+   }
+   return points;
+}
+
+// Distance from point to the segment from first to last.
+static GLfloat segment_distance (const vertex& point, const vertex& first,
+                                 const vertex& last) {
+   GLfloat dx = last.xpos - first.xpos;
+   GLfloat dy = last.ypos - first.ypos;
+   GLfloat length2 = dx * dx + dy * dy;
+   GLfloat t = length2 == 0 ? 0
+             : ((point.xpos - first.xpos) * dx
+               + (point.ypos - first.ypos) * dy) / length2;
+   t = max (0.0f, min (1.0f, t));
+   return hypotf (point.xpos - (first.xpos + t * dx),
+                  point.ypos - (first.ypos + t * dy));
+}
+
+//
+// Douglas-Peucker simplification of a closed outline: no removed
+// vertex is more than tolerance from the outline kept.  The ring is
+// split at vertex 0 and the vertex farthest from it, and the two
+// chains are simplified with an explicit stack, since a recursion
+// could be as deep as the outline is long.
+//
+static vertex_list simplify (const vertex_list& ring, GLfloat tolerance) {
+   size_t count = ring.size();
+   if (count <= 3) return ring;
+   auto at = [&ring, count] (size_t index) -> const vertex& {
+      return ring[index % count];
+   };
+   size_t far = 0;
+   GLfloat far_distance = 0;
+   for (size_t index = 1; index < count; ++index) {
+      GLfloat distance = hypotf (ring[index].xpos - ring[0].xpos,
+                                 ring[index].ypos - ring[0].ypos);
+      if (distance > far_distance) {
+         far = index;
+         far_distance = distance;
+      }
+   }
+   vector<bool> keep (count, false);
+   keep[0] = keep[far] = true;
+   vector<pair<size_t,size_t>> chains {{0, far}, {far, count}};
+   while (not chains.empty()) {
+      auto chain = chains.back();
+      chains.pop_back();
+      size_t split = chain.first;
+      GLfloat split_distance = tolerance;
+      for (size_t index = chain.first + 1; index < chain.second;
+           ++index) {
+         GLfloat distance = segment_distance (at (index),
+                                              at (chain.first),
+                                              at (chain.second));
+         if (distance > split_distance) {
+            split = index;
+            split_distance = distance;
+         }
+      }
+      if (split == chain.first) continue;
+      keep[split] = true;
+      chains.push_back ({chain.first, split});
+      chains.push_back ({split, chain.second});
+   }
+   vertex_list result;
+   result.reserve (std::count (keep.begin(), keep.end(), true));
+   for (size_t index = 0; index < count; ++index) {
+      if (keep[index]) result.push_back (ring[index]);
+   }
+   return result.size() < 3 ? ring : result;
+}
+
+// Level k is simplified from level k-1 by half its error bound, so
+// the errors of all the levels before it sum to less than the bound.
+// Level 0 is the vertices, so if they are packed, the caller must
+// decode them when given the empty vertex list.
+const vertex_list& polygon::detail (GLfloat pixels_per_unit) const {
+   if (size() < lod_threshold) return vertices;
+   if (not leveled) {
+      vertex_list decoded;
+      const vertex_list* previous = &vertices;
+      if (not packed.empty()) {
+         decoded = unpacked();
+         previous = &decoded;
+      }
+      for (GLfloat bound = lod_error; previous->size() > 4;
+           bound *= 2) {
+         vertex_list next = simplify (*previous, bound / 2);
+         if (next.size() == previous->size()) break;
+         levels.push_back (move (next));
+         previous = &levels.back();
+      }
+      leveled = true;
+      DEBUGF ('l', this << ": " << size() << " vertices, "
+              << levels.size() << " levels, coarsest "
+              << (levels.empty() ? size()
+                                 : levels.back().size()));
+   }
+   // The coarsest level whose bound is under half a pixel.
+   GLfloat allowed = 0.5 / pixels_per_unit;
+   const vertex_list* chosen = &vertices;
+   GLfloat bound = lod_error;
+   for (const vertex_list& level: levels) {
+      if (bound > allowed) break;
+      chosen = &level;
+      bound *= 2;
+   }
+   return *chosen;
+}
+
+// The window draws one unit per pixel.
+vertex_list polygon::outline() const {
+   const vertex_list& detailed = detail (1);
+   vertex_list points;
+   if (&detailed == &vertices) {
+      points.reserve (size());
+      for (size_t index = 0; index < size(); ++index) {
+         points.push_back (relative (index));
+      }
+      return points;
+   }
+   points.reserve (detailed.size());
+   for (const vertex& point: detailed) {
+      points.push_back ({point.xpos - centroid.xpos,
+                         point.ypos - centroid.ypos});
+   }
+   return points;
+}
+
 void shape::show (ostream& out) const {
    out << this << "->" << demangle (*this) << ": ";
 }
@@ -179,87 +508,75 @@ void ellipse::show (ostream& out) const {
 
 void polygon::show (ostream& out) const {
    shape::show (out);
-   out << "{" << vertices << "}";
+   out << "{" << unpacked() << "}";
 }
 
-ostream& operator<< (ostream& out, const shape& obj) {
-   obj.show (out);
-   return out;
+template <size_t N>
+void fixed_polygon<N>::show (ostream& out) const {
+   shape::show (out);
+   out << "{" << make_pair (vertices.cbegin(), vertices.cend()) << "}";
 }
 
-vertex_list rectangle::make_coords (GLfloat width, GLfloat height) {
-   vertex_list v; 
-   vertex pair; 
+// SVG font family and pixel size of each bitmap font.
+static unordered_map<void*,pair<const char*,int>> fontsvg {
+   {GLUT_BITMAP_8_BY_13       , {"monospace", 13}},
+   {GLUT_BITMAP_9_BY_15       , {"monospace", 15}},
+   {GLUT_BITMAP_HELVETICA_10  , {"Helvetica,sans-serif", 10}},
+   {GLUT_BITMAP_HELVETICA_12  , {"Helvetica,sans-serif", 12}},
+   {GLUT_BITMAP_HELVETICA_18  , {"Helvetica,sans-serif", 18}},
+   {GLUT_BITMAP_TIMES_ROMAN_10, {"Times,serif", 10}},
+   {GLUT_BITMAP_TIMES_ROMAN_24, {"Times,serif", 24}},
+};
 
-   // top left
-   pair.xpos = width/2;
-   pair.ypos = height/2; 
-   v.push_back(pair);
-   
-   // top right
-   pair.xpos = width;
-   pair.ypos = height/2; 
-   v.push_back(pair);
+// The baseline starts at the center, as for the raster position.
+void text::write_svg (svg_writer& out) const {
+   const auto& font = fontsvg[glut_bitmap_font];
+   out << "<text font-family=\"" << font.first << "\" font-size=\""
+       << size_t (font.second) << "\" xml:space=\"preserve\">";
+   for (char chr: textdata) {
+      switch (chr) {
+         case '&': out << "&amp;"; break;
+         case '<': out << "&lt;"; break;
+         case '>': out << "&gt;"; break;
+         default: out << chr; break;
+      }
+   }
+   out << "</text>";
+}
 
-   // bottom right
-   pair.xpos = width;
-   pair.ypos = height; 
-   v.push_back(pair);
+void ellipse::write_svg (svg_writer& out) const {
+   bbox box = bounds();
+   out << "<ellipse rx=\"" << box.high.xpos << "\" ry=\""
+       << box.high.ypos << "\"/>";
+}
 
-   // bottom left
-   pair.xpos = width/2;
-   pair.ypos = height; 
-   v.push_back(pair);
+// Every vertex, not a level of the pyramid: the reader may zoom.
+void polygon::write_svg (svg_writer& out) const {
+   out << "<polygon points=\"";
+   for (size_t index = 0; index < size(); ++index) {
+      vertex point = relative (index);
+      if (index > 0) out << " ";
+      out << point.xpos << "," << -point.ypos;
+   }
+   out << "\"/>";
+}
 
-   return v;
+template <size_t N>
+void fixed_polygon<N>::write_svg (svg_writer& out) const {
+   out << "<polygon points=\"";
+   for (size_t index = 0; index < N; ++index) {
+      if (index > 0) out << " ";
+      out << vertices[index].xpos - centroid.xpos << ","
+          << centroid.ypos - vertices[index].ypos;
+   }
+   out << "\"/>";
 }
 
-vertex_list diamond::make_coords (GLfloat width, GLfloat height) {
-   vertex_list v; 
-   vertex pair; 
+template class fixed_polygon<3>;
+template class fixed_polygon<4>;
 
-   // top center
-   pair.xpos = width/2;
-   pair.ypos = height; 
-   v.push_back(pair);
-   
-   // right
-   pair.xpos = width;
-   pair.ypos = height/2; 
-   v.push_back(pair);
-
-   // bottom center
-   pair.xpos = width/2;
-   pair.ypos = 0; 
-   v.push_back(pair);
-
-    // left
-   pair.xpos = 0;
-   pair.ypos = height/2; 
-   v.push_back(pair);
-  
-   return v;
-}
-
-vertex_list equilateral::make_coords (GLfloat width) {
-   vertex_list v; 
-   vertex pair; 
-
-   // left
-   pair.xpos = 0;
-   pair.ypos = 0; 
-   v.push_back(pair);
-   
-   // top
-   pair.xpos = width/2;
-   pair.ypos = width/2; 
-   v.push_back(pair);
-
-   // right
-   pair.xpos = width;
-   pair.ypos = 0; 
-   v.push_back(pair);
-  
-   return v;
+ostream& operator<< (ostream& out, const shape& obj) {
+   obj.show (out);
+   return out;
 }
 
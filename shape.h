@@ -3,6 +3,9 @@
 #ifndef __SHAPE_H__
 #define __SHAPE_H__
 
+#include <array>
+#include <cmath>
+#include <cstdint>
 #include <iomanip>
 #include <iostream>
 #include <memory>
@@ -22,28 +25,62 @@ using namespace std;
 //    ellipse
 //       circle
 //    polygon
-//       rectangle
-//          square
-//       diamond
 //       triangle
 //          right_triangle
 //          isosceles
-//          equilateral
+//    fixed_polygon<4>
+//       rectangle
+//          square
+//       diamond
+//    fixed_polygon<3>
+//       equilateral
 //
 
 class shape;
+class svg_writer;
 struct vertex {GLfloat xpos; GLfloat ypos; };
 using vertex_list = vector<vertex>;
 using shape_ptr = shared_ptr<shape>; 
 
+//
+// Axis-aligned bounding box.  An empty box has low above high,
+// so merging anything into it yields that thing.
+//
+
+struct bbox {
+   vertex low {HUGE_VALF, HUGE_VALF};
+   vertex high {-HUGE_VALF, -HUGE_VALF};
+   bool empty() const { return low.xpos > high.xpos; }
+   void merge (const bbox&);
+   bbox operator+ (const vertex& offset) const;
+   bool overlaps (const bbox&) const;
+   bool contains (const vertex&) const;
+};
+
+//
+// How a shape is drawn.  Shapes drawn as triangles can be batched
+// together, as can ellipses, which may also be drawn by a shader;
+// bitmaps must each be drawn on their own.
+//
+
+enum class primitive {TRIANGLES, ELLIPSE, BITMAP};
+
 //
 // Abstract base class for all shapes in this system.
 //
 
 class shape {
    friend ostream& operator<< (ostream& out, const shape&);
+   private:
+      mutable vertex_list border_strip; // Cached selection border.
+      mutable GLfloat border_thickness {0};
+      mutable vertex_list fill_triangles; // Cached fan of outline.
+      mutable bool filled {false};
    protected:
       inline shape(); // Only subclass may instantiate.
+      virtual vertex_list outline() const { return {}; }
+      virtual bool caches_fill() const { return true; }
+      const vertex_list& triangles() const;
    public:
       shape (const shape&) = delete; // Prevent copying.
       shape& operator= (const shape&) = delete; // Prevent copying.
@@ -51,7 +88,20 @@ class shape {
       shape& operator= (shape&&) = delete; // Prevent moving.
       virtual ~shape() {}
       virtual void draw (const vertex&, const rgbcolor&) const = 0;
+      virtual bbox bounds() const = 0; // Relative to the center.
+      virtual primitive kind() const { return primitive::TRIANGLES; }
+      // Emits the shape as triangles into an open GL_TRIANGLES
+      // batch, returning how many vertices it emitted.
+      virtual size_t fill (const vertex& center) const;
+      // Relative to the center, or empty for text.
+      vertex_list contour() const { return outline(); }
+      void prepare (GLfloat thickness) const;
+      void draw_border (const vertex&, const rgbcolor&,
+                        GLfloat thickness) const;
       virtual void show (ostream&) const;
+      // One SVG element, centered on the origin.  SVG's y axis
+      // points down, so y coordinates are negated.
+      virtual void write_svg (svg_writer&) const = 0;
 };
 
 
@@ -70,10 +120,19 @@ class text: public shape {
       // GLUT_BITMAP_TIMES_ROMAN_10
       // GLUT_BITMAP_TIMES_ROMAN_24
       string textdata;
+   private:
+      static vertex window_origin; // The point at window pixel 0,0.
    public:
       text (void* glut_bitmap_font, const string& textdata);
+      // Set with each projection, so that draw need not read it back.
+      static void set_window_origin (const vertex& origin) {
+                  window_origin = origin; }
       virtual void draw (const vertex&, const rgbcolor&) const override;
+      virtual bbox bounds() const override;
+      virtual primitive kind() const override {
+         return primitive::BITMAP; }
       virtual void show (ostream&) const override;
+      virtual void write_svg (svg_writer&) const override;
 };
 
 //
@@ -83,10 +142,15 @@ class text: public shape {
 class ellipse: public shape {
    protected:
       vertex dimension;
+      virtual vertex_list outline() const override;
    public:
       ellipse (GLfloat width, GLfloat height);
       virtual void draw (const vertex&, const rgbcolor&) const override;
+      virtual bbox bounds() const override;
+      virtual primitive kind() const override {
+         return primitive::ELLIPSE; }
       virtual void show (ostream&) const override;
+      virtual void write_svg (svg_writer&) const override;
 };
 
 class circle: public ellipse {
@@ -97,25 +161,103 @@ class circle: public ellipse {
 //
 // Class polygon.
 //
+// Polygons with many vertices are drawn from a pyramid of simplified
+// outlines, built on first use.  Level k differs from the vertices
+// by less than lod_error * 2^k, and the coarsest level whose error
+// is under half a pixel is drawn, so a huge outline covering a few
+// pixels costs a few vertices.
+//
+// With compact vertices, which must be asked for before polygons are
+// made, the vertices are kept as 16-bit steps across the bounding box
+// instead of floats, and decoded as they are drawn.  A polygon more
+// than 65535 units across would be off by more than half a unit, so
+// it keeps its floats.
+//
+
+struct packed_vertex { uint16_t xpos; uint16_t ypos; };
 
 class polygon: public shape {
    protected:
-      const vertex_list vertices;
+      static constexpr size_t lod_threshold = 64; // Fewer: no pyramid.
+      static constexpr GLfloat lod_error = 0.5;  // Of level 0, in units.
+      static constexpr GLfloat packed_steps = 65535;
+      static bool compact_vertices;
+      vertex_list vertices;   // Empty if packed.
+      vector<packed_vertex> packed;
+      vertex quantum {0, 0};  // Size of a packed step.
+      vertex centroid {0, 0};
+      bbox box; // Relative to the centroid.
+      mutable vector<vertex_list> levels; // Coarser with each level.
+      mutable bool leveled {false};
+      size_t size() const {
+         return packed.empty() ? vertices.size() : packed.size(); }
+      vertex relative (size_t index) const; // To the centroid.
+      vertex_list unpacked() const;
+      const vertex_list& detail (GLfloat pixels_per_unit) const;
+      virtual vertex_list outline() const override;
+      virtual bool caches_fill() const override {
+         return packed.empty(); }
    public:
-      polygon (const vertex_list& vertices);
+      static void set_compact (bool compact) {
+         compact_vertices = compact; }
+      polygon (vertex_list&& vertices); // Takes the list, never copies.
       virtual void draw (const vertex&, const rgbcolor&) const override;
+      virtual size_t fill (const vertex& center) const override;
+      virtual bbox bounds() const override { return box; }
       virtual void show (ostream&) const override;
+      virtual void write_svg (svg_writer&) const override;
 };
 
 
+//
+// Class fixed_polygon.
+//
+// A polygon whose N vertices are kept in the shape itself instead
+// of on the heap.  Coordinates come from constexpr functions and
+// loops over N unroll.  The members are defined in shape.cpp and
+// instantiated there for the arities used.
+//
+
+template <size_t N>
+class fixed_polygon: public shape {
+   public:
+      using coords = array<vertex,N>;
+   protected:
+      const coords vertices;
+      const vertex centroid;
+      static constexpr vertex centroid_of (const coords& points) {
+         vertex sum {0, 0};
+         for (size_t index = 0; index < N; ++index) {
+            sum.xpos += points[index].xpos;
+            sum.ypos += points[index].ypos;
+         }
+         return {sum.xpos / N, sum.ypos / N};
+      }
+      virtual vertex_list outline() const override;
+      virtual bool caches_fill() const override { return false; }
+   public:
+      fixed_polygon (const coords& vertices);
+      virtual void draw (const vertex&, const rgbcolor&) const override;
+      virtual size_t fill (const vertex& center) const override;
+      virtual bbox bounds() const override;
+      virtual void show (ostream&) const override;
+      virtual void write_svg (svg_writer&) const override;
+};
+
 //
 // Classes rectangle, square, etc.
 //
 
-class rectangle: public polygon {
+class rectangle: public fixed_polygon<4> {
    public:
       rectangle (GLfloat width, GLfloat height);
-      vertex_list make_coords (GLfloat begin, GLfloat end);
+      static constexpr coords make_coords (GLfloat width,
+                                           GLfloat height) {
+         return {{{width / 2, height / 2},  // top left
+                  {width, height / 2},      // top right
+                  {width, height},          // bottom right
+                  {width / 2, height}}};    // bottom left
+      }
 };
 
 class square: public rectangle {
@@ -123,20 +265,33 @@ class square: public rectangle {
       square (GLfloat width);
 };
 
-class diamond: public polygon {
+class diamond: public fixed_polygon<4> {
    public:
       diamond (const GLfloat width, const GLfloat height);
-      vertex_list make_coords (GLfloat begin, GLfloat end);
+      static constexpr coords make_coords (GLfloat width,
+                                           GLfloat height) {
+         return {{{width / 2, height},      // top center
+                  {width, height / 2},      // right
+                  {width / 2, 0},           // bottom center
+                  {0, height / 2}}};        // left
+      }
 };
 
 // Triangles are polygons
-class equilateral: public polygon {
+class equilateral: public fixed_polygon<3> {
    public:
       equilateral (const GLfloat width);
-      vertex_list make_coords (GLfloat begin);
+      static constexpr coords make_coords (GLfloat width) {
+         return {{{0, 0},                   // left
+                  {width / 2, width / 2},   // top
+                  {width, 0}}};             // right
+      }
 };
 
 ostream& operator<< (ostream& out, const shape&);
 
+// The GLUT bitmap font with a name such as Helvetica-12, or nullptr.
+void* bitmap_font (const string& name);
+
 #endif
 
@@ -0,0 +1,76 @@
+// $Id: stroke.cpp,v 1.1 2026-10-19 12:00:00-07 - - $
+
+#include <cmath>
+using namespace std;
+
+#include <GL/freeglut.h>
+
+#include "debug.h"
+#include "hud.h"
+#include "stroke.h"
+#include "util.h"
+
+// Unit normal to the edge running from one vertex to the next.
+static vertex edge_normal (const vertex& from, const vertex& to) {
+   GLfloat dx = to.xpos - from.xpos;
+   GLfloat dy = to.ypos - from.ypos;
+   GLfloat length = hypot (dx, dy);
+   if (length == 0) return {0, 0};
+   return {-dy / length, dx / length};
+}
+
+static void push_pair (vertex_list& strip, const vertex& point,
+                       const vertex& offset) {
+   strip.push_back ({point.xpos + offset.xpos,
+                     point.ypos + offset.ypos});
+   strip.push_back ({point.xpos - offset.xpos,
+                     point.ypos - offset.ypos});
+}
+
+vertex_list tessellate_stroke (const vertex_list& outline,
+                               GLfloat thickness) {
+   DEBUGF ('s', outline.size() << " vertices, thickness "
+           << thickness);
+   vertex_list strip;
+   size_t count = outline.size();
+   if (count < 2 or thickness <= 0) return strip;
+   GLfloat half = thickness / 2;
+   strip.reserve (4 * count + 2);
+   for (size_t index = 0; index < count; ++index) {
+      const vertex& prev = outline[(index + count - 1) % count];
+      const vertex& here = outline[index];
+      const vertex& next = outline[(index + 1) % count];
+      vertex in = edge_normal (prev, here);
+      vertex out = edge_normal (here, next);
+      vertex miter {in.xpos + out.xpos, in.ypos + out.ypos};
+      GLfloat length = hypot (miter.xpos, miter.ypos);
+      GLfloat cosine = length == 0 ? 0
+                     : (miter.xpos * in.xpos + miter.ypos * in.ypos)
+                       / length;
+      if (cosine > 1 / miter_limit) {
+         GLfloat scale = half / (length * cosine);
+         push_pair (strip, here, {miter.xpos * scale,
+                                  miter.ypos * scale});
+      }else {
+         // bevel: end the incoming edge, then start the outgoing one
+         push_pair (strip, here, {in.xpos * half, in.ypos * half});
+         push_pair (strip, here, {out.xpos * half, out.ypos * half});
+      }
+   }
+   // close the loop by repeating the first pair
+   strip.push_back (strip[0]);
+   strip.push_back (strip[1]);
+   return strip;
+}
+
+void draw_strip (const vertex_list& strip, const vertex& center,
+                 const rgbcolor& color) {
+   glColor3ubv (color.ubvec);
+   glBegin (GL_TRIANGLE_STRIP);
+   for (const vertex& point: strip) {
+      glVertex2f (center.xpos + point.xpos, center.ypos + point.ypos);
+   }
+   glEnd();
+   hud::count (strip.size());
+}
+
@@ -0,0 +1,26 @@
+// $Id: stroke.h,v 1.1 2026-10-19 12:00:00-07 - - $
+
+//
+// stroke -
+//    Tessellates the outline of a closed shape into a triangle strip
+//    of a given thickness.  Corners are mitered, falling back to a
+//    bevel when the miter would be longer than miter_limit times the
+//    half-thickness.  The outline is given relative to the center of
+//    the shape, so the strip can be cached and translated when drawn.
+//
+
+#ifndef __STROKE_H__
+#define __STROKE_H__
+
+#include "shape.h"
+
+constexpr GLfloat miter_limit = 4;
+
+vertex_list tessellate_stroke (const vertex_list& outline,
+                               GLfloat thickness);
+
+void draw_strip (const vertex_list& strip, const vertex& center,
+                 const rgbcolor& color);
+
+#endif
+
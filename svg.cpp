@@ -0,0 +1,136 @@
+// $Id: svg.cpp,v 1.1 2026-10-19 12:00:00-07 - - $
+
+#include <cerrno>
+#include <charconv>
+#include <fcntl.h>
+#include <unistd.h>
+#include <unordered_map>
+using namespace std;
+
+#include "debug.h"
+#include "graphics.h"
+#include "svg.h"
+#include "util.h"
+
+void svg_writer::write_all (const char* data, size_t size) {
+   while (ok and size > 0) {
+      ssize_t written = write (fd, data, size);
+      if (written < 0) {
+         if (errno == EINTR) continue;
+         ok = false;
+         break;
+      }
+      data += written;
+      size -= written;
+   }
+}
+
+void svg_writer::drain() {
+   write_all (buffer.data(), used);
+   used = 0;
+}
+
+svg_writer& svg_writer::operator<< (string_view text) {
+   if (used + text.size() > capacity) drain();
+   if (text.size() > capacity) {
+      write_all (text.data(), text.size());
+   }else {
+      text.copy (&buffer[used], text.size());
+      used += text.size();
+   }
+   return *this;
+}
+
+svg_writer& svg_writer::operator<< (GLfloat number) {
+   if (used + 32 > capacity) drain();
+   auto result = to_chars (&buffer[used], &buffer[capacity], number);
+   used = result.ptr - buffer.data();
+   return *this;
+}
+
+svg_writer& svg_writer::operator<< (size_t number) {
+   if (used + 32 > capacity) drain();
+   auto result = to_chars (&buffer[used], &buffer[capacity], number);
+   used = result.ptr - buffer.data();
+   return *this;
+}
+
+svg_writer& svg_writer::operator<< (const rgbcolor& color) {
+   static const char digits[] = "0123456789abcdef";
+   if (used + 7 > capacity) drain();
+   buffer[used++] = '#';
+   for (size_t index = 0; index < 3; ++index) {
+      buffer[used++] = digits[color.ubvec[index] >> 4];
+      buffer[used++] = digits[color.ubvec[index] & 0xF];
+   }
+   return *this;
+}
+
+int export_svg (const string& filename) {
+   int width = window::get_width();
+   int height = window::get_height();
+   int fd = open (filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+   if (fd < 0) {
+      syscall_error (filename);
+      return EXIT_FAILURE;
+   }
+   svg_writer out (fd);
+   out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+       << "<svg xmlns=\"http://www.w3.org/2000/svg\""
+       << " xmlns:xlink=\"http://www.w3.org/1999/xlink\" width=\""
+       << size_t (width) << "\" height=\"" << size_t (height)
+       << "\" viewBox=\"0 0 " << size_t (width) << " "
+       << size_t (height) << "\">\n"
+       << "<rect width=\"100%\" height=\"100%\" fill=\"#404040\"/>\n";
+
+   // Count the uses of each shape, then number the shared ones.
+   struct usage { size_t uses {0}; size_t symbol {0}; };
+   unordered_map<const shape*,usage> shapes;
+   for (size_t index = 0; index < window::size(); ++index) {
+      ++shapes[&window::at (index).get_shape()].uses;
+   }
+   size_t symbol_count = 0;
+   out << "<defs>\n";
+   for (size_t index = 0; index < window::size(); ++index) {
+      const shape& pshape = window::at (index).get_shape();
+      usage& entry = shapes[&pshape];
+      if (entry.uses < 2 or entry.symbol != 0) continue;
+      entry.symbol = ++symbol_count;
+      out << "<symbol id=\"s" << entry.symbol
+          << "\" overflow=\"visible\">";
+      pshape.write_svg (out);
+      out << "</symbol>\n";
+   }
+   out << "</defs>\n";
+   DEBUGF ('x', symbol_count << " symbols for " << shapes.size()
+           << " shapes");
+
+   // GL's y axis points up, SVG's down.
+   for (size_t index = 0; index < window::size(); ++index) {
+      const object& obj = window::at (index);
+      vertex offset = window::world_offset (index);
+      GLfloat xpos = obj.get_pos().xpos + offset.xpos;
+      GLfloat ypos = height - (obj.get_pos().ypos + offset.ypos);
+      size_t symbol = shapes[&obj.get_shape()].symbol;
+      if (symbol == 0) {
+         out << "<g transform=\"translate(" << xpos << " " << ypos
+             << ")\" fill=\"" << obj.get_color() << "\">";
+         obj.get_shape().write_svg (out);
+         out << "</g>\n";
+      }else {
+         out << "<use xlink:href=\"#s" << symbol << "\" x=\"" << xpos
+             << "\" y=\"" << ypos << "\" fill=\"" << obj.get_color()
+             << "\"/>\n";
+      }
+   }
+   out << "</svg>\n";
+
+   bool ok = out.flush();
+   if (not ok) syscall_error (filename);
+   if (close (fd) < 0 and ok) {
+      syscall_error (filename);
+      ok = false;
+   }
+   return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
@@ -0,0 +1,55 @@
+// $Id: svg.h,v 1.1 2026-10-19 12:00:00-07 - - $
+
+//
+// export_svg -
+//    Write the scene as an SVG document the size given by -w and -h.
+//    The objects are streamed in drawing order through one large
+//    buffer, never built into a document in memory.  A shape drawn
+//    more than once is written once as a <symbol> and each object
+//    drawing it is a <use>; a shape drawn once is written in place.
+//    Returns EXIT_SUCCESS or EXIT_FAILURE.
+//
+
+#ifndef __SVG_H__
+#define __SVG_H__
+
+#include <string>
+#include <string_view>
+#include <vector>
+using namespace std;
+
+#include <GL/freeglut.h>
+
+#include "rgbcolor.h"
+
+//
+// svg_writer -
+//    Appends text and numbers to a buffer, written out by write(2)
+//    whenever it fills.  Numbers are formatted by to_chars, which
+//    neither allocates nor consults the locale, and colors as #rrggbb.
+//
+
+class svg_writer {
+   private:
+      static constexpr size_t capacity = 1 << 20;
+      int fd;
+      vector<char> buffer;
+      size_t used {0};
+      bool ok {true};
+      void write_all (const char* data, size_t size);
+      void drain();
+   public:
+      svg_writer (int fd_): fd (fd_), buffer (capacity) {}
+      svg_writer& operator<< (string_view text);
+      svg_writer& operator<< (char chr) {
+                  return *this << string_view (&chr, 1); }
+      svg_writer& operator<< (GLfloat number);
+      svg_writer& operator<< (size_t number);
+      svg_writer& operator<< (const rgbcolor& color);
+      bool flush() { drain(); return ok; }
+};
+
+int export_svg (const string& filename);
+
+#endif
+
@@ -6,7 +6,7 @@ template <typename item_t>
 ostream& operator<< (ostream& out, const vector<item_t>& vec) {
    bool want_space = false;
    for (const auto& item: vec) {
-      if (want_space) cout << " ";
+      if (want_space) out << " ";
       out << item;
       want_space = true;
    }
@@ -17,7 +17,7 @@ template <typename iterator>
 ostream& operator<< (ostream& out, pair<iterator,iterator> range) {
    bool want_space = false;
    while (range.first != range.second) {
-      if (want_space) cout << " ";
+      if (want_space) out << " ";
       out << *range.first++;
       want_space = true;
    }